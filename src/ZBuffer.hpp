@@ -3,42 +3,196 @@
 #include <limits>
 #include <cassert>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "kernels/kernels.hpp"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
+/*
+Depth buffer with a coarse level of COARSE x COARSE pixel tiles.
+Each coarse tile keeps the farthest (max) depth stored in its pixels. It can only grow smaller, so an old value stays
+a valid bound: it is recomputed lazily, the first time it is queried once COARSE more runs were written to the tile.
+That is as many runs as covering the tile takes at least (runs never span rows), so the max of a tile still being
+filled is not recomputed row after row while it can only be infinite.
+A span whose nearest depth is not closer than the max of every coarse tile it crosses cannot pass TestAndSet
+anywhere, so the rasterizer can skip it before interpolating any attribute.
+Clearing does not touch the pixels: each entry is tagged with the frame (epoch) it was written in, Clear() moves to
+the next epoch and an entry of an older one reads as infinitely far. The tags are a byte per pixel, so they are
+reset with one fill every 255 frames when the counter wraps around.
+*/
 class ZBuffer
 {
 public:
+	static constexpr int COARSE = 8;
+
 	ZBuffer( int width, int height )
 		:
 		width( width ),
 		height( height ),
-		pBuffer( new float[width*height] )
+		coarseWidth( (width + COARSE - 1) / COARSE ),
+		coarseHeight( (height + COARSE - 1) / COARSE ),
+		pBuffer( new float[width*height] ),
+		pEpoch( new uint8_t[width*height]() ),
+		pMax( new float[coarseWidth*coarseHeight] ),
+		pWrites( new uint8_t[coarseWidth*coarseHeight] )
 	{}
 	ZBuffer( const ZBuffer& ) = delete;
 	~ZBuffer()
 	{
 		delete[] pBuffer;
+		delete[] pEpoch;
+		delete[] pMax;
+		delete[] pWrites;
 		pBuffer = nullptr;
 	}
 	void Clear()
 	{
-		std::fill_n(
-			pBuffer,
-			width * height,
-			std::numeric_limits<float>::infinity() // Initialize zBuffer to the maximum float value
-		);
+		if( ++epoch == 0 )
+		{
+			kernels().fill( pEpoch,width * height,0 );
+			epoch = 1;
+		}
+		std::fill_n( pMax, coarseWidth * coarseHeight, std::numeric_limits<float>::infinity() );
+		std::fill_n( pWrites, coarseWidth * coarseHeight, 0 );
 	}
 	bool TestAndSet( int pos,float depth )
 	{
-		float& depthInBuffer = pBuffer[pos];
-		if( depth < depthInBuffer )
+		if( pEpoch[pos] != epoch || depth < pBuffer[pos] )
+		{
+			pBuffer[pos] = depth;
+			pEpoch[pos] = epoch;
+			return true;
+		}
+		return false;
+	}
+	// Main pass after a Z-prepass: the buffer already holds the nearest depth, so only a fragment at that depth passes.
+	// The entry is then used up, so a coplanar fragment drawn later is not shaded too and the first one wins like with
+	// TestAndSet. The coarse max is left as is, it stays a valid (conservative) bound.
+	bool TestEqual( int pos,float depth )
+	{
+		if( pEpoch[pos] != epoch || depth <= pBuffer[pos] )
 		{
-			depthInBuffer = depth;
+			pBuffer[pos] = -std::numeric_limits<float>::infinity();
+			pEpoch[pos] = epoch;
 			return true;
 		}
 		return false;
 	}
+	// Records that pixels were written at (x, y); call once per written run inside a coarse tile.
+	void MarkWritten( int x,int y )
+	{
+		uint8_t& writes = pWrites[(y / COARSE) * coarseWidth + x / COARSE];
+		if( writes < COARSE )
+		{
+			++writes;
+		}
+	}
+	// True when no pixel of row y in [x0, x1) can pass TestAndSet (or TestEqual when orEqual) with a depth of at least depth.
+	bool IsOccluded( int y,int x0,int x1,float depth,bool orEqual = false )
+	{
+		int row = (y / COARSE) * coarseWidth;
+		for( int cx = x0 / COARSE; cx <= (x1 - 1) / COARSE; ++cx )
+		{
+			float max = TileMax( row + cx );
+			if( depth < max || (orEqual && depth == max) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+	// True when pixel pos was written since the last Clear(), i.e. something was drawn there this frame.
+	bool Written( int pos ) const
+	{
+		return pEpoch[pos] == epoch;
+	}
+	// Length of the run of pixels from pos, at most count, that are all Written() like pos or all not.
+	int CoverageRun( int pos,int count ) const
+	{
+		const bool written = Written( pos );
+		int n = 1;
+#if defined(__SSE2__)
+		const __m128i current = _mm_set1_epi8( static_cast<char>(epoch) );
+		for( ; n + 16 <= count; n += 16 )
+		{
+			__m128i tags = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pEpoch + pos + n) );
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8( _mm_cmpeq_epi8( tags,current ) ));
+			unsigned other = written ? ~mask & 0xffff : mask; // Pixels whose state differs from pos
+			if( other != 0 )
+			{
+				return n + __builtin_ctz( other );
+			}
+		}
+#endif
+		while( n < count && Written( pos + n ) == written )
+		{
+			++n;
+		}
+		return n;
+	}
+	float TileMax( int x,int y )
+	{
+		return TileMax( (y / COARSE) * coarseWidth + x / COARSE );
+	}
 private:
+	float TileMax( int tile )
+	{
+		if( pWrites[tile] == COARSE )
+		{
+			pMax[tile] = ComputeMax( tile );
+			pWrites[tile] = 0;
+		}
+		return pMax[tile];
+	}
+	float ComputeMax( int tile ) const
+	{
+		int x0 = (tile % coarseWidth) * COARSE;
+		int y0 = (tile / coarseWidth) * COARSE;
+		int x1 = std::min( x0 + COARSE,width );
+		int y1 = std::min( y0 + COARSE,height );
+		const float inf = std::numeric_limits<float>::infinity();
+		float result = -inf;
+#if defined(__SSE2__)
+		if( x1 - x0 == COARSE )
+		{
+			const uint64_t current = 0x0101010101010101ull * epoch;
+			__m128 acc = _mm_set1_ps( result );
+			for( int y = y0; y < y1; ++y )
+			{
+				uint64_t tags;
+				std::memcpy( &tags,pEpoch + y * width + x0,sizeof( tags ) );
+				if( tags != current )
+				{
+					return inf; // A pixel not written this frame
+				}
+				const float* row = pBuffer + y * width + x0;
+				acc = _mm_max_ps( acc,_mm_max_ps( _mm_loadu_ps( row ),_mm_loadu_ps( row + 4 ) ) );
+			}
+			acc = _mm_max_ps( acc,_mm_shuffle_ps( acc,acc,_MM_SHUFFLE( 1,0,3,2 ) ) );
+			acc = _mm_max_ps( acc,_mm_shuffle_ps( acc,acc,_MM_SHUFFLE( 2,3,0,1 ) ) );
+			return _mm_cvtss_f32( acc );
+		}
+#endif
+		for( int y = y0; y < y1; ++y )
+		{
+			for( int x = x0; x < x1; ++x )
+			{
+				int pos = y * width + x;
+				result = std::max( result,pEpoch[pos] == epoch ? pBuffer[pos] : inf );
+			}
+		}
+		return result;
+	}
+
 	int width;
 	int height;
+	int coarseWidth;
+	int coarseHeight;
 	float* pBuffer = nullptr;
-};
\ No newline at end of file
+	uint8_t* pEpoch = nullptr; // Epoch each entry of pBuffer was written in
+	uint8_t epoch = 0;
+	float* pMax = nullptr;
+	uint8_t* pWrites = nullptr; // Runs written since pMax was computed, up to COARSE
+};
@@ -1,13 +1,36 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <vector>
 
+/*
+A background is generated once per resolution: draw() keeps the last image it generated and only copies it while
+the size stays the same, so a window resize pays for one generate() and every other call is a plain copy.
+*/
 class Background {
 
     public:
-        virtual void draw(uint32_t *pixels, uint16_t height, uint16_t width) = 0;
+        void draw(uint32_t *pixels, uint16_t height, uint16_t width) {
+            if (height != cachedHeight || width != cachedWidth) {
+                cache.resize(static_cast<size_t>(width) * height);
+                generate(cache.data(), height, width);
+                cachedHeight = height;
+                cachedWidth = width;
+            }
+            std::memcpy(pixels, cache.data(), cache.size() * sizeof(uint32_t));
+        }
 
         virtual ~Background() {}
 
+    protected:
+        // Writes the background at this resolution, in the ARGB8888 format of the framebuffer.
+        virtual void generate(uint32_t *pixels, uint16_t height, uint16_t width) = 0;
+
+    private:
+        std::vector<uint32_t> cache;
+        uint16_t cachedHeight = 0;
+        uint16_t cachedWidth = 0;
+
 };
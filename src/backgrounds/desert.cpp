@@ -1,4 +1,5 @@
 #include <iostream>
+#include <vector>
 #include "desert.hpp"
 
 void Desert::calcPalette(uint32_t *palette) {
@@ -24,14 +25,11 @@ void Desert::calcPalette(uint32_t *palette) {
 }
 
 
-void Desert::draw(uint32_t *pixels, uint16_t height, uint16_t width) {
+void Desert::generate(uint32_t *pixels, uint16_t height, uint16_t width) {
 
     seed1 = 0x1234;
     seed2 = 0x2293;
-    uint8_t* greys = new uint8_t[width * height];
-
-    uint32_t* desertPalette = new uint32_t[64];
-    Desert::calcPalette(desertPalette);
+    std::vector<uint8_t> greys(width * height);
 
     const uint8_t desertBase[40] = { 
         15,15,16,16,17,19,21,23,26,29,31,31,31,35,39,42,45,43,60,57,
@@ -60,7 +58,4 @@ void Desert::draw(uint32_t *pixels, uint16_t height, uint16_t width) {
         pixels[point] = desertPalette[grey];
     }
 
-    delete[] desertPalette;
-    delete[] greys;
-
 }
\ No newline at end of file
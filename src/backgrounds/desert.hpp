@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <array>
 #include "background.hpp"
 
 class Desert : public Background {
@@ -10,8 +11,13 @@ class Desert : public Background {
         uint16_t seed2;
 
     public:
-        void draw(uint32_t *pixels, uint16_t height, uint16_t width);
+        Desert() { calcPalette(desertPalette.data()); }
+
+    protected:
+        void generate(uint32_t *pixels, uint16_t height, uint16_t width) override;
 
     private:
+        std::array<uint32_t, 64> desertPalette;
+
         void calcPalette(uint32_t *palette);
 };
@@ -1,21 +1,19 @@
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include "imagepng.hpp"
 #include "../vendor/lodepng.h"
 
-void Imagepng::draw(uint32_t *pixels, uint16_t high_in, uint16_t width_in) {
+void Imagepng::load() {
 
     std::vector<unsigned char> buffer;
-    std::vector<unsigned char> image; // the raw pixels
+    std::vector<unsigned char> rgba; // the raw pixels
     lodepng::load_file(buffer, "resources/2000.png");
 
-    unsigned img_width, img_height;
     lodepng::State state;
 
     // decode
-    unsigned error = lodepng::decode(image, img_width, img_height, state, buffer);
-
-    const LodePNGColorMode& color = state.info_png.color;
-    auto bpp = lodepng_get_bpp(&color);  // Not really used in your current code
+    unsigned error = lodepng::decode(rgba, imageWidth, imageHeight, state, buffer);
 
     if (error)
     {
@@ -23,25 +21,27 @@ void Imagepng::draw(uint32_t *pixels, uint16_t high_in, uint16_t width_in) {
         exit(1);
     }
 
-    // Now we have image (RGBA 8bit data), img_width, img_height
-    // Fill the destination buffer
-    for (uint16_t y = 0; y < high_in; ++y) {
-        for (uint16_t x = 0; x < width_in; ++x) {
-
-            // Repeat or clip the image as required
-            unsigned src_x = (x < img_width) ? x : (x % img_width);
-            unsigned src_y = (y < img_height) ? y : (y % img_height);
+    // Now we have RGBA 8bit data, converted once to the ARGB of the framebuffer
+    image.resize(static_cast<size_t>(imageWidth) * imageHeight);
+    for (size_t i = 0; i < image.size(); ++i) {
+        uint8_t r = rgba[i * 4 + 0];
+        uint8_t g = rgba[i * 4 + 1];
+        uint8_t b = rgba[i * 4 + 2];
+        uint8_t a = rgba[i * 4 + 3];
+        image[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
 
-            // Index into the source image (RGBA, so 4 bytes per pixel)
-            size_t src_index = (src_y * img_width + src_x) * 4;
+void Imagepng::generate(uint32_t *pixels, uint16_t high_in, uint16_t width_in) {
 
-            uint8_t r = image[src_index + 0];
-            uint8_t g = image[src_index + 1];
-            uint8_t b = image[src_index + 2];
-            uint8_t a = image[src_index + 3];
+    if (image.empty()) load();
 
-            // You can choose any pixel format. Let's use ARGB here.
-            pixels[y * width_in + x] = (a << 24) | (r << 16) | (g << 8) | b;
+    // Repeat or clip the image as required: each destination row is its source row copied in image wide pieces
+    for (uint16_t y = 0; y < high_in; ++y) {
+        const uint32_t* src = image.data() + static_cast<size_t>(y % imageHeight) * imageWidth;
+        uint32_t* dst = pixels + static_cast<size_t>(y) * width_in;
+        for (unsigned x = 0; x < width_in; x += imageWidth) {
+            std::memcpy(dst + x, src, std::min<unsigned>(imageWidth, width_in - x) * sizeof(uint32_t));
         }
     }
 
@@ -1,11 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 #include "background.hpp"
 
 class Imagepng : public Background {
 
-    public:
-        void draw(uint32_t *pixels, uint16_t height, uint16_t width);
+    protected:
+        void generate(uint32_t *pixels, uint16_t height, uint16_t width) override;
+
+    private:
+        // resources/2000.png decoded on first use and already converted to ARGB8888
+        std::vector<uint32_t> image;
+        unsigned imageWidth = 0;
+        unsigned imageHeight = 0;
+
+        void load();
 
 };
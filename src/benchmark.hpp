@@ -0,0 +1,103 @@
+#pragma once
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "kernels/kernels.hpp"
+
+/*
+Table shared by the benchmarks below: one row per shading mode, one column per setting. For each cell apply(column)
+selects the setting, then the scene is rendered once to warm up the caches and a fixed number of frames more, and
+the average frame time in ms is printed, followed by the pixels shaded in the last frame when withShaded is set.
+The shading of the solids is restored afterwards; restoring what apply changes is left to the caller.
+*/
+inline void runShadingBenchmark(Renderer& renderer, Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back, int frames,
+                                const std::vector<std::string>& columns, auto&& apply, bool withShaded = false)
+{
+    const Shading shadings[] = {
+        Shading::Flat, Shading::Gouraud, Shading::BlinnPhong, Shading::Phong,
+        Shading::TexturedFlat, Shading::TexturedGouraud, Shading::TexturedBlinnPhong, Shading::TexturedPhong
+    };
+
+    std::vector<Shading> savedShading;
+    for (auto& solidPtr : scene.solids) savedShading.push_back(solidPtr->shading);
+
+    std::cout << std::left << std::setw(22) << "shading";
+    for (const std::string& column : columns) {
+        std::cout << std::setw(14) << column;
+        if (withShaded) std::cout << std::setw(14) << "shaded";
+    }
+    std::cout << std::endl;
+
+    for (Shading shading : shadings) {
+        for (auto& solidPtr : scene.solids) solidPtr->shading = shading;
+        std::cout << std::setw(22) << shadingToString(shading);
+
+        for (size_t column = 0; column < columns.size(); ++column) {
+            apply(column);
+            renderer.drawScene(scene, zNear, zFar, viewAngle, back); // Warm up caches
+
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < frames; ++i) {
+                renderer.drawScene(scene, zNear, zFar, viewAngle, back);
+            }
+            auto end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / frames;
+            std::cout << std::setw(14) << std::fixed << std::setprecision(3) << ms;
+            if (withShaded) std::cout << std::setw(14) << renderer.frameStats().shadedPixels;
+        }
+        std::cout << std::endl;
+    }
+
+    for (size_t i = 0; i < scene.solids.size(); ++i) scene.solids[i]->shading = savedShading[i];
+}
+
+/*
+Every shading mode with each raster backend, so the backends can be compared on the same geometry.
+The raster mode of the renderer is restored afterwards.
+*/
+inline void runRasterBenchmark(Renderer& renderer, Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back, int frames = 100)
+{
+    const RasterMode modes[] = { RasterMode::Scanline, RasterMode::HalfSpace };
+    RasterMode savedMode = renderer.getRasterMode();
+
+    runShadingBenchmark(renderer, scene, zNear, zFar, viewAngle, back, frames,
+                        { rasterModeToString(modes[0]), rasterModeToString(modes[1]) },
+                        [&](size_t column) { renderer.setRasterMode(modes[column]); });
+
+    renderer.setRasterMode(savedMode);
+}
+
+/*
+Same without and with the Z-prepass, in the current raster mode, with the number of pixels shaded in the last frame.
+The Z-prepass setting is restored afterwards.
+*/
+inline void runPrepassBenchmark(Renderer& renderer, Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back, int frames = 100)
+{
+    bool savedPrepass = renderer.getZPrepass();
+
+    runShadingBenchmark(renderer, scene, zNear, zFar, viewAngle, back, frames, { "no prepass", "z-prepass" },
+                        [&](size_t column) { renderer.setZPrepass(column == 1); }, true);
+
+    renderer.setZPrepass(savedPrepass);
+}
+
+/*
+Same for every kernel variant the CPU supports (see kernels/kernels.hpp), with the current renderer settings.
+The variant in use is restored afterwards.
+*/
+inline void runKernelBenchmark(Renderer& renderer, Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back, int frames = 100)
+{
+    const std::vector<const Kernels*> variants = supportedKernels();
+    const Kernels& savedKernels = kernels();
+
+    std::vector<std::string> names;
+    for (const Kernels* variant : variants) names.push_back(variant->name);
+    runShadingBenchmark(renderer, scene, zNear, zFar, viewAngle, back, frames, names,
+                        [&](size_t column) { useKernels(*variants[column]); });
+
+    useKernels(savedKernels);
+}
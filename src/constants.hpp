@@ -2,3 +2,8 @@
 constexpr double PI = 3.14159;
 constexpr float RAD = PI/180;
 constexpr const char* RES_PATH = "resources/";
+constexpr int TILE_SIZE = 64; // Side in pixels of the screen tiles used to bin triangles
+constexpr int GUARD_BAND = 8192; // Max distance in pixels from the screen origin for triangles that skip side clipping
+constexpr int SUBPIXEL_BITS = 4; // Fractional bits of the fixed point screen positions of the vertices
+constexpr int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+constexpr int FACE_CLUSTER = 128; // Faces per cluster in the coarse front-to-back sort of large meshes
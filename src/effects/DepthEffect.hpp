@@ -0,0 +1,88 @@
+#pragma once
+#include "../slib.hpp"
+#include "../varyings.hpp"
+
+// depth only, used by the Z-prepass: no attribute is interpolated and there is no pixel shader
+class DepthEffect
+{
+public:
+	// No pixel shader, so nothing is interpolated
+	static constexpr unsigned VARYINGS = varying::None;
+
+	// the vertex type that will be input into the pipeline
+	// Screen position and depth are computed exactly like in the other effects so that the depths written by the
+	// prepass compare equal to the ones of the main pass.
+	class Vertex
+	{
+	public:
+    Vertex() {}
+
+    Vertex(int32_t px, int32_t py, float pz, slib::vec4 vp) :
+    p_x(px), p_y(py), p_z(pz), ndc(vp) {}
+
+    Vertex operator+(const Vertex &v) const {
+        return Vertex(p_x + v.p_x, p_y + v.p_y, p_z + v.p_z, ndc + v.ndc);
+    }
+
+    Vertex operator-(const Vertex &v) const {
+        return Vertex(p_x - v.p_x, p_y - v.p_y, p_z - v.p_z, ndc - v.ndc);
+    }
+
+    Vertex operator*(const float &rhs) const {
+        return Vertex(p_x * rhs, p_y * rhs, p_z * rhs, ndc * rhs);
+    }
+
+
+    Vertex& operator+=(const Vertex &v) {
+        p_x += v.p_x;
+        p_y += v.p_y;
+        p_z += v.p_z;
+        ndc += v.ndc;
+        return *this;
+    }
+
+	public:
+        int32_t p_x;
+        int32_t p_y;
+        float p_z;
+        slib::vec3 world;
+        slib::vec3 point;
+        slib::vec4 ndc;
+	};
+
+	class VertexShader
+	{
+	public:
+        void operator()(const VertexData& vData, const slib::mat4& fullTransformMat, const slib::mat4& viewMatrix, const slib::mat4& normalTransformMat, const Scene& scene, Vertex& screenPoint) const
+		{
+            screenPoint.world = fullTransformMat * slib::vec4(vData.vertex, 1);
+            screenPoint.point =  slib::vec4(screenPoint.world, 1) * viewMatrix;
+            screenPoint.ndc = slib::vec4(screenPoint.point, 1) * scene.projectionMatrix;
+		}
+
+        // Same as above for a vertex already transformed by the batch vertex stage.
+        void operator()(const TransformedVertex& tv, const Scene& scene, Vertex& screenPoint) const
+		{
+            screenPoint.world = tv.world;
+            screenPoint.ndc = tv.ndc;
+		}
+
+        void viewProjection(const Scene& scene, Vertex& p) {
+            float oneOverW = 1.0f / p.ndc.w;
+            p.p_x = smath::toSubpixel((p.ndc.x * oneOverW + 1.0f) * (scene.screen.width / 2.0f)); // Convert from NDC to fixed point screen coordinates
+            p.p_y = smath::toSubpixel((p.ndc.y * oneOverW + 1.0f) * (scene.screen.height / 2.0f)); // Convert from NDC to fixed point screen coordinates
+            p.p_z = p.ndc.z * oneOverW; // Store the depth value in the z-buffer
+        }
+	};
+
+    class GeometryShader
+	{
+	public:
+        void operator()(Triangle<Vertex>& tri, const Scene& scene) const
+		{
+		}
+	};
+public:
+    VertexShader vs;
+    GeometryShader gs;
+};
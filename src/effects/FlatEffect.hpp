@@ -1,11 +1,15 @@
 #pragma once
 #include "../slib.hpp"
+#include "../varyings.hpp"
 #include "../color.hpp"
 
 // solid color attribute not interpolated
 class FlatEffect
 {
 public:
+	// Vertex attributes read by the pixel shader, the only ones interpolated by the raster loops
+	static constexpr unsigned VARYINGS = varying::None;
+
 	// the vertex type that will be input into the pipeline
 	class Vertex
 	{
@@ -48,19 +52,24 @@ public:
 	class VertexShader
 	{
 	public:
-        std::unique_ptr<Vertex> operator()(const VertexData& vData, const slib::mat4& fullTransformMat, const slib::mat4& viewMatrix, const slib::mat4& normalTransformMat, const Scene& scene) const
+        void operator()(const VertexData& vData, const slib::mat4& fullTransformMat, const slib::mat4& viewMatrix, const slib::mat4& normalTransformMat, const Scene& scene, Vertex& screenPoint) const
 		{
-            Vertex screenPoint;
             screenPoint.world = fullTransformMat * slib::vec4(vData.vertex, 1);
             screenPoint.point =  slib::vec4(screenPoint.world, 1) * viewMatrix;
             screenPoint.ndc = slib::vec4(screenPoint.point, 1) * scene.projectionMatrix;
-            return std::make_unique<Vertex>(screenPoint);
+		}
+
+        // Same as above for a vertex already transformed by the batch vertex stage.
+        void operator()(const TransformedVertex& tv, const Scene& scene, Vertex& screenPoint) const
+		{
+            screenPoint.world = tv.world;
+            screenPoint.ndc = tv.ndc;
 		}
 
         void viewProjection(const Scene& scene, Vertex& p) {
             float oneOverW = 1.0f / p.ndc.w;
-            p.p_x = static_cast<int>((p.ndc.x * oneOverW + 1.0f) * (scene.screen.width / 2.0f)); // Convert from NDC to screen coordinates
-            p.p_y = static_cast<int>((p.ndc.y * oneOverW + 1.0f) * (scene.screen.height / 2.0f)); // Convert from NDC to screen coordinates
+            p.p_x = smath::toSubpixel((p.ndc.x * oneOverW + 1.0f) * (scene.screen.width / 2.0f)); // Convert from NDC to fixed point screen coordinates
+            p.p_y = smath::toSubpixel((p.ndc.y * oneOverW + 1.0f) * (scene.screen.height / 2.0f)); // Convert from NDC to fixed point screen coordinates
             p.p_z = p.ndc.z * oneOverW; // Store the depth value in the z-buffer
         }
 	};
@@ -1,12 +1,17 @@
 #pragma once
 #include <cmath>
 #include "../slib.hpp"
+#include "../varyings.hpp"
+#include "../kernels/kernels.hpp"
 #include "../color.hpp"
 
 // solid color attribute not interpolated
 class TexturedPhongEffect
 {
 public:
+	// Vertex attributes read by the pixel shader, the only ones interpolated by the raster loops
+	static constexpr unsigned VARYINGS = varying::Normal | varying::Tex;
+
 	// the vertex type that will be input into the pipeline
 	class Vertex
 	{
@@ -52,21 +57,28 @@ public:
 	class VertexShader
 	{
 	public:
-        std::unique_ptr<Vertex> operator()(const VertexData& vData, const slib::mat4& fullTransformMat, const slib::mat4& viewMatrix, const slib::mat4& normalTransformMat, const Scene& scene) const
+        void operator()(const VertexData& vData, const slib::mat4& fullTransformMat, const slib::mat4& viewMatrix, const slib::mat4& normalTransformMat, const Scene& scene, Vertex& screenPoint) const
 		{
-            Vertex screenPoint;
             screenPoint.world = fullTransformMat * slib::vec4(vData.vertex, 1);
             screenPoint.point =  slib::vec4(screenPoint.world, 1) * viewMatrix;
             screenPoint.ndc = slib::vec4(screenPoint.point, 1) * scene.projectionMatrix;
             screenPoint.tex = slib::zvec2(vData.texCoord.x, vData.texCoord.y, 1);
             screenPoint.normal = normalTransformMat * slib::vec4(vData.normal, 0);
-            return std::make_unique<Vertex>(screenPoint);
+		}
+
+        // Same as above for a vertex already transformed by the batch vertex stage.
+        void operator()(const TransformedVertex& tv, const Scene& scene, Vertex& screenPoint) const
+		{
+            screenPoint.world = tv.world;
+            screenPoint.ndc = tv.ndc;
+            screenPoint.tex = slib::zvec2(tv.texCoord.x, tv.texCoord.y, 1);
+            screenPoint.normal = tv.normal;
 		}
 
         void viewProjection(const Scene& scene, Vertex& p) {
             float oneOverW = 1.0f / p.ndc.w;
-            p.p_x = static_cast<int>((p.ndc.x * oneOverW + 1.0f) * (scene.screen.width / 2.0f)); // Convert from NDC to screen coordinates
-            p.p_y = static_cast<int>((p.ndc.y * oneOverW + 1.0f) * (scene.screen.height / 2.0f)); // Convert from NDC to screen coordinates
+            p.p_x = smath::toSubpixel((p.ndc.x * oneOverW + 1.0f) * (scene.screen.width / 2.0f)); // Convert from NDC to fixed point screen coordinates
+            p.p_y = smath::toSubpixel((p.ndc.y * oneOverW + 1.0f) * (scene.screen.height / 2.0f)); // Convert from NDC to fixed point screen coordinates
             p.p_z = p.ndc.z * oneOverW; // Store the depth value in the z-buffer
             p.tex.x = p.tex.x * oneOverW;
             p.tex.y = p.tex.y * oneOverW;
@@ -121,6 +133,16 @@ public:
             }
 
 		}
+
+		/*
+		Packet version: the lighting of the PIXEL_PACKET pixels of packet is computed at once with the kernel variant of
+		the CPU, the texel fetches are still done one lane at a time. Lanes outside mask hold no pixel and their colors
+		are ignored.
+		*/
+		void operator()(const VaryingPacket& packet, int mask, const Scene& scene, Triangle<Vertex>& tri, uint32_t* colors) const
+		{
+            kernels().phongPacket(packet, mask, { scene.lux, scene.eye, &tri.material, true }, colors);
+		}
 	};
 public:
     VertexShader vs;
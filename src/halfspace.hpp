@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/*
+Coverage of a block of 8 consecutive pixels on a scanline against the three edge functions of a triangle.
+Each edge function is an integer that is >= 0 for pixels inside the edge and grows by a fixed step per pixel in x,
+so the 8 values of a block are the value at the first pixel plus a constant lane offset.
+mask() returns a bit per pixel (bit i = pixel i of the block) set when the pixel is inside all three edges.
+Uses AVX2 when available, SSE2 otherwise, and plain integers as the last resort.
+*/
+class CoverageBlock8
+{
+public:
+    CoverageBlock8(int step0, int step1, int step2)
+    {
+#if defined(__AVX2__)
+        const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        offset[0] = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step0));
+        offset[1] = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step1));
+        offset[2] = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step2));
+#elif defined(__SSE2__)
+        const int steps[3] = {step0, step1, step2};
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = _mm_setr_epi32(0, steps[k], 2 * steps[k], 3 * steps[k]);
+            hi[k] = _mm_setr_epi32(4 * steps[k], 5 * steps[k], 6 * steps[k], 7 * steps[k]);
+        }
+#else
+        steps[0] = step0;
+        steps[1] = step1;
+        steps[2] = step2;
+#endif
+    }
+
+    inline int mask(int e0, int e1, int e2) const
+    {
+#if defined(__AVX2__)
+        // A pixel is inside when no edge value is negative, i.e. the sign bit of (w0 | w1 | w2) is clear.
+        __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(e0), offset[0]);
+        __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(e1), offset[1]);
+        __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(e2), offset[2]);
+        __m256i any = _mm256_or_si256(_mm256_or_si256(w0, w1), w2);
+        return ~_mm256_movemask_ps(_mm256_castsi256_ps(any)) & 0xff;
+#elif defined(__SSE2__)
+        __m128i e[3] = {_mm_set1_epi32(e0), _mm_set1_epi32(e1), _mm_set1_epi32(e2)};
+        __m128i anyLo = _mm_or_si128(_mm_or_si128(_mm_add_epi32(e[0], lo[0]), _mm_add_epi32(e[1], lo[1])), _mm_add_epi32(e[2], lo[2]));
+        __m128i anyHi = _mm_or_si128(_mm_or_si128(_mm_add_epi32(e[0], hi[0]), _mm_add_epi32(e[1], hi[1])), _mm_add_epi32(e[2], hi[2]));
+        int outside = _mm_movemask_ps(_mm_castsi128_ps(anyLo)) | (_mm_movemask_ps(_mm_castsi128_ps(anyHi)) << 4);
+        return ~outside & 0xff;
+#else
+        int result = 0;
+        for (int i = 0; i < 8; ++i) {
+            if ((e0 + i * steps[0]) >= 0 && (e1 + i * steps[1]) >= 0 && (e2 + i * steps[2]) >= 0) {
+                result |= 1 << i;
+            }
+        }
+        return result;
+#endif
+    }
+
+private:
+#if defined(__AVX2__)
+    __m256i offset[3];
+#elif defined(__SSE2__)
+    __m128i lo[3];
+    __m128i hi[3];
+#else
+    int steps[3];
+#endif
+};
@@ -0,0 +1,34 @@
+#include "kernels.hpp"
+
+namespace kernels_sse2 { extern const Kernels table; }
+#if defined(__x86_64__) || defined(__i386__)
+namespace kernels_sse41 { extern const Kernels table; }
+namespace kernels_avx2 { extern const Kernels table; }
+#endif
+
+namespace
+{
+    const Kernels* forced = nullptr; // Set by useKernels()
+}
+
+std::vector<const Kernels*> supportedKernels() {
+
+    std::vector<const Kernels*> variants = { &kernels_sse2::table };
+#if defined(__x86_64__) || defined(__i386__)
+    // Also checks that the OS saves the AVX registers (XGETBV), not only the cpuid bits
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) variants.push_back(&kernels_sse41::table);
+    if (__builtin_cpu_supports("avx2")) variants.push_back(&kernels_avx2::table);
+#endif
+    return variants;
+}
+
+const Kernels& kernels() {
+
+    static const Kernels* best = supportedKernels().back(); // Thread safe, detected once
+    return forced ? *forced : *best;
+}
+
+void useKernels(const Kernels& variant) {
+    forced = &variant;
+}
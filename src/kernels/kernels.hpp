@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "../slib.hpp"
+#include "../vertexBatch.hpp"
+#include "../varyings.hpp"
+
+/*
+Hot loops built once per instruction set level, so that a single binary runs them with the widest vector unit of
+the machine it lands on. Each variant is the same code (kernelsIsa.hpp) compiled in its own file under a
+#pragma GCC target: sse2 is the baseline every x86-64 CPU has, then sse4.1 and avx2. AVX-512 CPUs run the avx2
+variant: the pixel packets are 8 lanes wide, so the same code under an avx512 target would not be any faster.
+kernels() picks the best one the CPU reports through cpuid the first time it is called.
+The raster loops themselves (coverage, span and plane stepping) stay inlined in the Rasterizer templates at the
+baseline level: they run per pixel block, where an indirect call would cost more than it saves.
+*/
+
+// Lighting inputs of a packet besides the varyings. view is the eye direction for Phong and the halfway vector for
+// Blinn-Phong. When textured, the diffuse color comes from material->map_Kd instead of Ka and Kd.
+struct PacketLighting
+{
+    slib::vec3 light;
+    slib::vec3 view;
+    const slib::material* material;
+    bool textured;
+};
+
+struct Kernels
+{
+    const char* name;
+
+    // Vertex stage: world, clip and normal of VERTEX_BATCH vertices, see vertexBatch.hpp
+    void (*transformVertexBatch)(const VertexSoA& soa, int first, const BatchMatrices& m, TransformedVertex* out);
+
+    // Full frame buffer clears (depth epochs, visibility buffer), with non-temporal stores
+    void (*fill)(void* dst, size_t bytes, uint8_t value);
+
+    // Packet pixel shading of PIXEL_PACKET pixels, lanes outside mask are left alone (colors[i] is still written)
+    void (*phongPacket)(const VaryingPacket& packet, int mask, const PacketLighting& lighting, uint32_t* colors);
+    void (*blinnPhongPacket)(const VaryingPacket& packet, int mask, const PacketLighting& lighting, uint32_t* colors);
+};
+
+// The variant in use, chosen with cpuid on the first call.
+const Kernels& kernels();
+
+// Variants built into the binary that this CPU can run, baseline first.
+std::vector<const Kernels*> supportedKernels();
+
+// Replaces the variant in use, e.g. to compare them; it must be one of supportedKernels().
+void useKernels(const Kernels& variant);
@@ -0,0 +1,15 @@
+// AVX2 variant of the kernels, see kernels.hpp.
+#if defined(__x86_64__) || defined(__i386__)
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include "kernels.hpp"
+
+#pragma GCC target("avx2")
+#define KERNELS_AVX2
+#define KERNELS_NAME "avx2"
+namespace kernels_avx2
+{
+#include "kernelsIsa.hpp"
+}
+#endif
@@ -0,0 +1,505 @@
+/*
+Body of one kernel variant, see kernels.hpp. There is no include guard on purpose: each kernels*.cpp file includes it
+once, inside the namespace of its variant and after its #pragma GCC target, so every function here is compiled for
+that instruction set. The pragma does not define __AVX2__ and friends in C++, so the variant files select the code
+paths with KERNELS_AVX2 and KERNELS_SSE41 instead. Everything this file needs is included by the variant file
+before the pragma, so that the standard library keeps its baseline code.
+All variants do the same float operations in the same order, so on a given CPU they give the same results.
+*/
+
+/*
+PIXEL_PACKET floats used as one value by the packet pixel shaders, one lane per pixel.
+Uses one AVX2 register in the avx2 variant, two SSE halves otherwise, and plain floats as the last resort.
+load() and store() expect 32 byte aligned arrays.
+*/
+struct Float8
+{
+#if defined(KERNELS_AVX2)
+    __m256 v;
+#elif defined(__SSE2__)
+    __m128 lo, hi;
+#else
+    float f[PIXEL_PACKET];
+#endif
+
+    static Float8 set(float a)
+    {
+        Float8 r;
+#if defined(KERNELS_AVX2)
+        r.v = _mm256_set1_ps(a);
+#elif defined(__SSE2__)
+        r.lo = r.hi = _mm_set1_ps(a);
+#else
+        std::fill(r.f, r.f + PIXEL_PACKET, a);
+#endif
+        return r;
+    }
+
+    static Float8 load(const float* p)
+    {
+        Float8 r;
+#if defined(KERNELS_AVX2)
+        r.v = _mm256_load_ps(p);
+#elif defined(__SSE2__)
+        r.lo = _mm_load_ps(p);
+        r.hi = _mm_load_ps(p + 4);
+#else
+        std::copy(p, p + PIXEL_PACKET, r.f);
+#endif
+        return r;
+    }
+
+    void store(float* p) const
+    {
+#if defined(KERNELS_AVX2)
+        _mm256_store_ps(p, v);
+#elif defined(__SSE2__)
+        _mm_store_ps(p, lo);
+        _mm_store_ps(p + 4, hi);
+#else
+        std::copy(f, f + PIXEL_PACKET, p);
+#endif
+    }
+};
+
+#if defined(KERNELS_AVX2)
+#define FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) { Float8 r; r.v = avx(a.v, b.v); return r; }
+#elif defined(__SSE2__)
+#define FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) { Float8 r; r.lo = sse(a.lo, b.lo); r.hi = sse(a.hi, b.hi); return r; }
+#else
+#define FLOAT8_BINARY(name, avx, sse, expr) \
+    inline Float8 name(const Float8& a, const Float8& b) { Float8 r; for (int i = 0; i < PIXEL_PACKET; ++i) { float x = a.f[i], y = b.f[i]; r.f[i] = (expr); } return r; }
+#endif
+
+FLOAT8_BINARY(operator+, _mm256_add_ps, _mm_add_ps, x + y)
+FLOAT8_BINARY(operator-, _mm256_sub_ps, _mm_sub_ps, x - y)
+FLOAT8_BINARY(operator*, _mm256_mul_ps, _mm_mul_ps, x * y)
+FLOAT8_BINARY(operator/, _mm256_div_ps, _mm_div_ps, x / y)
+FLOAT8_BINARY(max, _mm256_max_ps, _mm_max_ps, std::max(x, y))
+FLOAT8_BINARY(min, _mm256_min_ps, _mm_min_ps, std::min(x, y))
+#undef FLOAT8_BINARY
+
+inline Float8 operator*(const Float8& a, float b) { return a * Float8::set(b); }
+inline Float8 operator+(const Float8& a, float b) { return a + Float8::set(b); }
+
+// 1 / sqrt(a) from the hardware estimate and one Newton-Raphson step, about 23 bits.
+inline Float8 rsqrt(const Float8& a)
+{
+#if defined(KERNELS_AVX2) || defined(__SSE2__)
+    Float8 y;
+#if defined(KERNELS_AVX2)
+    y.v = _mm256_rsqrt_ps(a.v);
+#else
+    y.lo = _mm_rsqrt_ps(a.lo);
+    y.hi = _mm_rsqrt_ps(a.hi);
+#endif
+    return y * (Float8::set(1.5f) - a * Float8::set(0.5f) * y * y);
+#else
+    Float8 r;
+    for (int i = 0; i < PIXEL_PACKET; ++i) r.f[i] = 1.0f / std::sqrt(a.f[i]);
+    return r;
+#endif
+}
+
+// Register helpers of the exp2 / log2 approximations below, for the width Float8 uses.
+namespace lanes
+{
+#if defined(KERNELS_AVX2)
+    typedef __m256 Reg;
+    typedef __m256i IReg;
+    inline Reg set(float a) { return _mm256_set1_ps(a); }
+    inline Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    inline Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    inline Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    inline Reg clamp(Reg a, float lo, float hi) { return _mm256_min_ps(_mm256_max_ps(a, set(lo)), set(hi)); }
+    inline IReg bits(Reg a) { return _mm256_castps_si256(a); }
+    inline Reg fromBits(IReg a) { return _mm256_castsi256_ps(a); }
+    inline IReg iset(int a) { return _mm256_set1_epi32(a); }
+    inline IReg iadd(IReg a, IReg b) { return _mm256_add_epi32(a, b); }
+    inline IReg isub(IReg a, IReg b) { return _mm256_sub_epi32(a, b); }
+    inline IReg iand(IReg a, IReg b) { return _mm256_and_si256(a, b); }
+    inline IReg ior(IReg a, IReg b) { return _mm256_or_si256(a, b); }
+    inline IReg shr(IReg a, int n) { return _mm256_srli_epi32(a, n); }
+    inline IReg shl(IReg a, int n) { return _mm256_slli_epi32(a, n); }
+    inline Reg toFloat(IReg a) { return _mm256_cvtepi32_ps(a); }
+    inline IReg roundToInt(Reg a) { return _mm256_cvtps_epi32(a); }
+#elif defined(__SSE2__)
+    typedef __m128 Reg;
+    typedef __m128i IReg;
+    inline Reg set(float a) { return _mm_set1_ps(a); }
+    inline Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+    inline Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+    inline Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+    inline Reg clamp(Reg a, float lo, float hi) { return _mm_min_ps(_mm_max_ps(a, set(lo)), set(hi)); }
+    inline IReg bits(Reg a) { return _mm_castps_si128(a); }
+    inline Reg fromBits(IReg a) { return _mm_castsi128_ps(a); }
+    inline IReg iset(int a) { return _mm_set1_epi32(a); }
+    inline IReg iadd(IReg a, IReg b) { return _mm_add_epi32(a, b); }
+    inline IReg isub(IReg a, IReg b) { return _mm_sub_epi32(a, b); }
+    inline IReg iand(IReg a, IReg b) { return _mm_and_si128(a, b); }
+    inline IReg ior(IReg a, IReg b) { return _mm_or_si128(a, b); }
+    inline IReg shr(IReg a, int n) { return _mm_srli_epi32(a, n); }
+    inline IReg shl(IReg a, int n) { return _mm_slli_epi32(a, n); }
+    inline Reg toFloat(IReg a) { return _mm_cvtepi32_ps(a); }
+    inline IReg roundToInt(Reg a) { return _mm_cvtps_epi32(a); }
+#endif
+
+#if defined(KERNELS_AVX2) || defined(__SSE2__)
+    inline Reg log2(Reg x)
+    {
+        // x = 2^e * m with m in [1, 2): log2(x) = e + p(m) * (m - 1)
+        IReg i = bits(x);
+        Reg e = toFloat(isub(shr(i, 23), iset(127)));
+        Reg m = fromBits(ior(iand(i, iset(0x007fffff)), iset(0x3f800000)));
+        Reg p = set(-3.4436006e-2f);
+        p = add(mul(p, m), set(3.1821337e-1f));
+        p = add(mul(p, m), set(-1.2315303f));
+        p = add(mul(p, m), set(2.5988452f));
+        p = add(mul(p, m), set(-3.3241990f));
+        p = add(mul(p, m), set(3.1157899f));
+        return add(mul(p, sub(m, set(1.0f))), e);
+    }
+
+    inline Reg exp2(Reg x)
+    {
+        // 2^x = 2^i * 2^f: i = floor(x) goes to the exponent bits and f in [0, 1) to a polynomial
+        x = clamp(x, -126.99999f, 127.99999f);
+        IReg i = roundToInt(sub(x, set(0.5f)));
+        Reg f = sub(x, toFloat(i));
+        Reg p = set(1.8775767e-3f);
+        p = add(mul(p, f), set(8.9893397e-3f));
+        p = add(mul(p, f), set(5.5826318e-2f));
+        p = add(mul(p, f), set(2.4015361e-1f));
+        p = add(mul(p, f), set(6.9315308e-1f));
+        p = add(mul(p, f), set(9.9999994e-1f));
+        return mul(fromBits(shl(iadd(i, iset(127)), 23)), p);
+    }
+
+    inline Reg pow(Reg x, float n)
+    {
+        // The smallest normal float keeps log2 finite, so x = 0 lands at the bottom of the exponential range
+        x = clamp(x, 1.17549435e-38f, 3.40282347e+38f);
+        return exp2(mul(log2(x), set(n)));
+    }
+#endif
+}
+
+/*
+x^n for x >= 0 as exp2(n * log2(x)), with minimax polynomials for the logarithm of the mantissa and the exponential
+of the fraction. The relative error is about n * 7e-6, so less than half a step of a color channel for the usual
+shininess values; x = 0 gives 0, or 1 when n = 0.
+*/
+inline Float8 pow(const Float8& x, float n)
+{
+    Float8 r;
+#if defined(KERNELS_AVX2)
+    r.v = lanes::pow(x.v, n);
+#elif defined(__SSE2__)
+    r.lo = lanes::pow(x.lo, n);
+    r.hi = lanes::pow(x.hi, n);
+#else
+    for (int i = 0; i < PIXEL_PACKET; ++i) r.f[i] = std::pow(x.f[i], n);
+#endif
+    return r;
+}
+
+/*
+Packs 8 colors to 0xff, x, y, z bytes exactly like Color::toBgra: truncated to integers, and scaled down together
+when the largest component is over 255.
+*/
+inline void toBgra(const Float8& x, const Float8& y, const Float8& z, uint32_t* out)
+{
+    Float8 largest = max(max(x, y), z);
+#if defined(KERNELS_AVX2)
+    __m256 over = _mm256_cmp_ps(largest.v, _mm256_set1_ps(255.0f), _CMP_GT_OQ);
+    __m256 scale = _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_div_ps(_mm256_set1_ps(255.0f), largest.v), over);
+    __m256i bx = _mm256_cvttps_epi32(_mm256_mul_ps(x.v, scale));
+    __m256i by = _mm256_cvttps_epi32(_mm256_mul_ps(y.v, scale));
+    __m256i bz = _mm256_cvttps_epi32(_mm256_mul_ps(z.v, scale));
+    __m256i bgra = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(static_cast<int>(0xff000000)), _mm256_slli_epi32(bx, 16)),
+                                   _mm256_or_si256(_mm256_slli_epi32(by, 8), bz));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), bgra);
+#elif defined(__SSE2__)
+    const __m128 x4[2] = {x.lo, x.hi}, y4[2] = {y.lo, y.hi}, z4[2] = {z.lo, z.hi}, largest4[2] = {largest.lo, largest.hi};
+    for (int h = 0; h < 2; ++h) {
+        __m128 over = _mm_cmpgt_ps(largest4[h], _mm_set1_ps(255.0f));
+        __m128 scaled = _mm_div_ps(_mm_set1_ps(255.0f), largest4[h]);
+#if defined(KERNELS_SSE41)
+        __m128 scale = _mm_blendv_ps(_mm_set1_ps(1.0f), scaled, over);
+#else
+        __m128 scale = _mm_or_ps(_mm_and_ps(over, scaled), _mm_andnot_ps(over, _mm_set1_ps(1.0f)));
+#endif
+        __m128i bx = _mm_cvttps_epi32(_mm_mul_ps(x4[h], scale));
+        __m128i by = _mm_cvttps_epi32(_mm_mul_ps(y4[h], scale));
+        __m128i bz = _mm_cvttps_epi32(_mm_mul_ps(z4[h], scale));
+        __m128i bgra = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(static_cast<int>(0xff000000)), _mm_slli_epi32(bx, 16)),
+                                    _mm_or_si128(_mm_slli_epi32(by, 8), bz));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * h), bgra);
+    }
+#else
+    for (int i = 0; i < PIXEL_PACKET; ++i) {
+        float scale = largest.f[i] > 255.0f ? 255.0f / largest.f[i] : 1.0f;
+        out[i] = 0xff000000 | (static_cast<int>(x.f[i] * scale)) << 16 | (static_cast<int>(y.f[i] * scale)) << 8 | static_cast<int>(z.f[i] * scale);
+    }
+#endif
+}
+
+// Three component vectors of a packet, one Float8 per component.
+struct Vec3x8
+{
+    Float8 x, y, z;
+
+    static Vec3x8 load(const float (&c)[3][PIXEL_PACKET])
+    {
+        return { Float8::load(c[0]), Float8::load(c[1]), Float8::load(c[2]) };
+    }
+};
+
+inline Vec3x8 operator*(const Vec3x8& a, const Float8& b) { return { a.x * b, a.y * b, a.z * b }; }
+inline Vec3x8 operator-(const Vec3x8& a, const slib::vec3& b) { return { a.x - Float8::set(b.x), a.y - Float8::set(b.y), a.z - Float8::set(b.z) }; }
+
+// Against a vector shared by all the lanes, like the light or the eye direction.
+inline Float8 dot(const Vec3x8& a, const slib::vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Float8 dot(const Vec3x8& a, const Vec3x8& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline Vec3x8 normalize(const Vec3x8& a)
+{
+    return a * rsqrt(dot(a, a));
+}
+
+/*
+Transforms VERTEX_BATCH vertices starting at first: world position, clip position and normal in one pass.
+Uses one AVX2 register per channel, two SSE halves otherwise, and plain floats as the last resort.
+*/
+inline void transformVertexBatch(const VertexSoA& soa, int first, const BatchMatrices& m, TransformedVertex* out)
+{
+    alignas(32) float world[3][VERTEX_BATCH];
+    alignas(32) float clip[4][VERTEX_BATCH];
+    alignas(32) float normal[3][VERTEX_BATCH];
+
+#if defined(KERNELS_AVX2)
+    __m256 x = _mm256_load_ps(&soa.x[first]);
+    __m256 y = _mm256_load_ps(&soa.y[first]);
+    __m256 z = _mm256_load_ps(&soa.z[first]);
+    for (int r = 0; r < 3; ++r) {
+        __m256 acc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.model[r][0]), x), _mm256_set1_ps(m.model[r][3]));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.model[r][1]), y));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.model[r][2]), z));
+        _mm256_store_ps(world[r], acc);
+    }
+    for (int j = 0; j < 4; ++j) {
+        __m256 acc = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.clip[0][j]), x), _mm256_set1_ps(m.clip[3][j]));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.clip[1][j]), y));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.clip[2][j]), z));
+        _mm256_store_ps(clip[j], acc);
+    }
+    __m256 nx = _mm256_load_ps(&soa.nx[first]);
+    __m256 ny = _mm256_load_ps(&soa.ny[first]);
+    __m256 nz = _mm256_load_ps(&soa.nz[first]);
+    for (int r = 0; r < 3; ++r) {
+        __m256 acc = _mm256_mul_ps(_mm256_set1_ps(m.normal[r][0]), nx);
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.normal[r][1]), ny));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(m.normal[r][2]), nz));
+        _mm256_store_ps(normal[r], acc);
+    }
+#elif defined(__SSE2__)
+    for (int h = 0; h < VERTEX_BATCH; h += 4) {
+        __m128 x = _mm_load_ps(&soa.x[first + h]);
+        __m128 y = _mm_load_ps(&soa.y[first + h]);
+        __m128 z = _mm_load_ps(&soa.z[first + h]);
+        for (int r = 0; r < 3; ++r) {
+            __m128 acc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.model[r][0]), x), _mm_set1_ps(m.model[r][3]));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.model[r][1]), y));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.model[r][2]), z));
+            _mm_store_ps(&world[r][h], acc);
+        }
+        for (int j = 0; j < 4; ++j) {
+            __m128 acc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.clip[0][j]), x), _mm_set1_ps(m.clip[3][j]));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.clip[1][j]), y));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.clip[2][j]), z));
+            _mm_store_ps(&clip[j][h], acc);
+        }
+        __m128 nx = _mm_load_ps(&soa.nx[first + h]);
+        __m128 ny = _mm_load_ps(&soa.ny[first + h]);
+        __m128 nz = _mm_load_ps(&soa.nz[first + h]);
+        for (int r = 0; r < 3; ++r) {
+            __m128 acc = _mm_mul_ps(_mm_set1_ps(m.normal[r][0]), nx);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.normal[r][1]), ny));
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(m.normal[r][2]), nz));
+            _mm_store_ps(&normal[r][h], acc);
+        }
+    }
+#else
+    for (int i = 0; i < VERTEX_BATCH; ++i) {
+        float x = soa.x[first + i], y = soa.y[first + i], z = soa.z[first + i];
+        for (int r = 0; r < 3; ++r)
+            world[r][i] = m.model[r][0] * x + m.model[r][1] * y + m.model[r][2] * z + m.model[r][3];
+        for (int j = 0; j < 4; ++j)
+            clip[j][i] = m.clip[0][j] * x + m.clip[1][j] * y + m.clip[2][j] * z + m.clip[3][j];
+        float nx = soa.nx[first + i], ny = soa.ny[first + i], nz = soa.nz[first + i];
+        for (int r = 0; r < 3; ++r)
+            normal[r][i] = m.normal[r][0] * nx + m.normal[r][1] * ny + m.normal[r][2] * nz;
+    }
+#endif
+
+    for (int i = 0; i < VERTEX_BATCH; ++i) {
+        out[i].world = {world[0][i], world[1][i], world[2][i]};
+        out[i].ndc = {clip[0][i], clip[1][i], clip[2][i], clip[3][i]};
+        out[i].normal = {normal[0][i], normal[1][i], normal[2][i]};
+        out[i].texCoord = {soa.u[first + i], soa.v[first + i]};
+    }
+}
+
+/*
+Full frame buffer fill, with non-temporal stores: a frame buffer is larger than the caches, so the stores go
+straight to memory instead of first reading every line in and evicting what the rasterizer works on.
+The destination is aligned with plain stores first, and an sfence makes the streamed data visible to the other
+threads before returning.
+*/
+inline void fill(void* dst, size_t bytes, uint8_t value)
+{
+    auto* d = static_cast<uint8_t*>(dst);
+    size_t i = 0;
+#if defined(KERNELS_AVX2)
+    for (; i < bytes && (reinterpret_cast<uintptr_t>(d + i) & 31) != 0; ++i) d[i] = value;
+    const __m256i v = _mm256_set1_epi8(static_cast<char>(value));
+    for (; i + 32 <= bytes; i += 32) _mm256_stream_si256(reinterpret_cast<__m256i*>(d + i), v);
+#elif defined(__SSE2__)
+    for (; i < bytes && (reinterpret_cast<uintptr_t>(d + i) & 15) != 0; ++i) d[i] = value;
+    const __m128i v = _mm_set1_epi8(static_cast<char>(value));
+    for (; i + 16 <= bytes; i += 16) _mm_stream_si128(reinterpret_cast<__m128i*>(d + i), v);
+#endif
+    for (; i < bytes; ++i) d[i] = value;
+#if defined(KERNELS_AVX2) || defined(__SSE2__)
+    _mm_sfence();
+#endif
+}
+
+/*
+Perspective corrected color of map_Kd for the lanes in mask, with the same arithmetic as smath::sampleNearest and
+smath::sampleBilinear. Texels are fetched one lane at a time, the bilinear weights and blend are done per packet.
+Lanes outside mask come out black.
+*/
+inline void samplePacket(const slib::texture& map, const VaryingPacket& p, int mask, float (&rgb)[3][PIXEL_PACKET])
+{
+    Float8 w = Float8::set(1.0f) / Float8::load(p.tex[2]);
+    alignas(32) float u[PIXEL_PACKET], v[PIXEL_PACKET];
+    (Float8::load(p.tex[0]) * w).store(u);
+    (Float8::load(p.tex[1]) * w).store(v);
+    const int bpp = static_cast<int>(map.bpp);
+
+    if (map.textureFilter != slib::TextureFilter::BILINEAR) {
+        for (int i = 0; i < PIXEL_PACKET; ++i) {
+            if ((mask & (1 << i)) == 0) {
+                rgb[0][i] = rgb[1][i] = rgb[2][i] = 0.0f;
+                continue;
+            }
+            int tx = static_cast<int>(u[i] * (map.w - 1));
+            int ty = static_cast<int>(v[i] * (map.h - 1));
+            const unsigned char* texel = &map.data[(ty * map.w + tx) * bpp];
+            for (int c = 0; c < 3; ++c) rgb[c][i] = static_cast<float>(texel[c]);
+        }
+        return;
+    }
+
+    // Corners in the order top left, bottom left, top right, bottom right
+    alignas(32) float fracU[PIXEL_PACKET], fracV[PIXEL_PACKET], corner[4][3][PIXEL_PACKET];
+    for (int i = 0; i < PIXEL_PACKET; ++i) {
+        if ((mask & (1 << i)) == 0) {
+            fracU[i] = fracV[i] = 0.0f;
+            for (auto& c : corner) c[0][i] = c[1][i] = c[2][i] = 0.0f;
+            continue;
+        }
+        float tx = u[i] * map.w - 0.5f;
+        float ty = v[i] * map.h - 0.5f;
+        int left = std::clamp(static_cast<int>(tx), 0, map.w - 2);
+        int top = std::clamp(static_cast<int>(ty), 0, map.h - 2);
+        fracU[i] = tx - left;
+        fracV[i] = ty - top;
+        const unsigned char* tL = &map.data[(top * map.w + left) * bpp];
+        const unsigned char* bL = tL + map.w * bpp;
+        for (int c = 0; c < 3; ++c) {
+            corner[0][c][i] = tL[c];
+            corner[1][c][i] = bL[c];
+            corner[2][c][i] = tL[bpp + c];
+            corner[3][c][i] = bL[bpp + c];
+        }
+    }
+
+    Float8 one = Float8::set(1.0f);
+    Float8 fu = Float8::load(fracU), fv = Float8::load(fracV);
+    Float8 ul = (one - fu) * (one - fv);
+    Float8 ll = (one - fu) * fv;
+    Float8 ur = fu * (one - fv);
+    Float8 lr = fu * fv;
+    for (int c = 0; c < 3; ++c) {
+        (ul * Float8::load(corner[0][c]) + ll * Float8::load(corner[1][c]) +
+         ur * Float8::load(corner[2][c]) + lr * Float8::load(corner[3][c])).store(rgb[c]);
+    }
+}
+
+/*
+Phong (REFLECT: the light reflected about the normal against the eye) or Blinn-Phong (the normal against the halfway
+vector) lighting of a packet, then its colors: Ka + Kd * diffuse + Ks * specular, or texture * diffuse + Ks * specular.
+*/
+template<bool REFLECT>
+inline void lightPacket(const VaryingPacket& packet, int mask, const PacketLighting& lighting, uint32_t* colors)
+{
+    const slib::material& material = *lighting.material;
+    const Float8 zero = Float8::set(0.0f);
+
+    Vec3x8 normal = normalize(Vec3x8::load(packet.normal));
+    Float8 nl = dot(normal, lighting.light);
+    Float8 diff = max(zero, nl);
+    Float8 specAngle;
+    if constexpr (REFLECT) {
+        Vec3x8 R = normalize(normal * (nl * 2.0f) - lighting.light);
+        specAngle = max(zero, dot(R, lighting.view));
+    } else {
+        specAngle = max(zero, dot(normal, lighting.view));
+    }
+    Float8 spec = pow(specAngle, material.Ns);
+
+    const auto& Ks = material.Ks;
+    if (lighting.textured) {
+        alignas(32) float rgb[3][PIXEL_PACKET];
+        samplePacket(material.map_Kd, packet, mask, rgb);
+        toBgra(Float8::load(rgb[0]) * diff + spec * Ks.x,
+               Float8::load(rgb[1]) * diff + spec * Ks.y,
+               Float8::load(rgb[2]) * diff + spec * Ks.z, colors);
+    } else {
+        const auto& Ka = material.Ka;
+        const auto& Kd = material.Kd;
+        toBgra(Float8::set(Ka.x) + diff * Kd.x + spec * Ks.x,
+               Float8::set(Ka.y) + diff * Kd.y + spec * Ks.y,
+               Float8::set(Ka.z) + diff * Kd.z + spec * Ks.z, colors);
+    }
+}
+
+inline void phongPacket(const VaryingPacket& packet, int mask, const PacketLighting& lighting, uint32_t* colors)
+{
+    lightPacket<true>(packet, mask, lighting, colors);
+}
+
+inline void blinnPhongPacket(const VaryingPacket& packet, int mask, const PacketLighting& lighting, uint32_t* colors)
+{
+    lightPacket<false>(packet, mask, lighting, colors);
+}
+
+extern const Kernels table;
+const Kernels table = {
+    KERNELS_NAME,
+    transformVertexBatch,
+    fill,
+    phongPacket,
+    blinnPhongPacket
+};
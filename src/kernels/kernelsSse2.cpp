@@ -0,0 +1,13 @@
+// Baseline variant of the kernels, see kernels.hpp. On non x86 targets it is the only one and uses plain floats.
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "kernels.hpp"
+
+#define KERNELS_NAME "sse2"
+namespace kernels_sse2
+{
+#include "kernelsIsa.hpp"
+}
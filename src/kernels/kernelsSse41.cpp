@@ -0,0 +1,15 @@
+// SSE4.1 variant of the kernels, see kernels.hpp.
+#if defined(__x86_64__) || defined(__i386__)
+#include <algorithm>
+#include <cmath>
+#include <immintrin.h>
+#include "kernels.hpp"
+
+#pragma GCC target("sse4.1")
+#define KERNELS_SSE41
+#define KERNELS_NAME "sse41"
+namespace kernels_sse41
+{
+#include "kernelsIsa.hpp"
+}
+#endif
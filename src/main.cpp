@@ -8,6 +8,8 @@
 #include "backgrounds/backgroundFactory.hpp"
 #include "scene.hpp"
 #include "average.hpp"
+#include "benchmark.hpp"
+#include "renderThread.hpp"
 
 int main(int argc, char** argv)
 {
@@ -49,6 +51,15 @@ int main(int argc, char** argv)
     scene.camera.yaw = 0;
     scene.setup();
 
+    // Persistent texture the finished framebuffer is uploaded to each frame, same XRGB layout as Scene's buffers
+    SDL_Texture* frameTexture = SDL_CreateTexture(sdlRenderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STREAMING,
+                                                  scene.screen.width, scene.screen.height);
+    if (frameTexture == nullptr)
+    {
+        std::cout << "Could not create SDL texture. Exiting..." << std::endl;
+        exit(1);
+    }
+
     float zNear = 100.0f; // Near plane distance
     float zFar  = 10000.0f; // Far plane distance
     float viewAngle = 45.0f; // Field of view angle in degrees
@@ -62,6 +73,13 @@ int main(int argc, char** argv)
 
     float mouseSensitivity = 0.1f;
     float cameraSpeed = 100.0f;
+    // From here on the scene and the renderer belong to the render thread: input only edits state, which is handed
+    // over as a snapshot each time the render thread starts a frame.
+    SceneSnapshot state = SceneSnapshot::capture(scene, renderer);
+    RenderThread renderThread(renderer, scene, zNear, zFar, viewAngle, back);
+    renderThread.start();
+    from = SDL_GetTicks();
+
     // Main loop.
     while (isRunning)
     {
@@ -73,67 +91,94 @@ int main(int argc, char** argv)
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
                 isRunning = false;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_LEFT) {
-                scene.camera.yaw = scene.camera.yaw + 1;
+                state.camera.yaw = state.camera.yaw + 1;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_RIGHT) {
-                scene.camera.yaw = scene.camera.yaw - 1;
+                state.camera.yaw = state.camera.yaw - 1;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_UP) {
-                scene.camera.pitch = scene.camera.pitch - 1;
+                state.camera.pitch = state.camera.pitch - 1;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_DOWN) {
-                scene.camera.pitch = scene.camera.pitch + 1;
+                state.camera.pitch = state.camera.pitch + 1;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_q) {
-                scene.camera.pos = scene.camera.pos - scene.camera.forward * cameraSpeed; 
+                state.camera.pos = state.camera.pos - state.camera.direction() * cameraSpeed; 
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_a) {
-                scene.camera.pos = scene.camera.pos + scene.camera.forward * cameraSpeed; 
+                state.camera.pos = state.camera.pos + state.camera.direction() * cameraSpeed; 
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_f) {
-                scene.solids[0]->shading = Shading::Flat;
+                state.solids[0].shading = Shading::Flat;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_r) {
-                scene.solids[0]->shading = Shading::TexturedFlat;
+                state.solids[0].shading = Shading::TexturedFlat;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_g) {
-                scene.solids[0]->shading = Shading::Gouraud;
+                state.solids[0].shading = Shading::Gouraud;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_t) {
-                scene.solids[0]->shading = Shading::TexturedGouraud;
+                state.solids[0].shading = Shading::TexturedGouraud;
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_h) {
-                scene.solids[0]->shading = Shading::BlinnPhong; 
+                state.solids[0].shading = Shading::BlinnPhong; 
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_y) {
-                scene.solids[0]->shading = Shading::TexturedBlinnPhong;                                 
+                state.solids[0].shading = Shading::TexturedBlinnPhong;                                 
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_j) {
-                scene.solids[0]->shading = Shading::Phong;   
+                state.solids[0].shading = Shading::Phong;   
             } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_u) {
-                scene.solids[0]->shading = Shading::TexturedPhong;                                                 
+                state.solids[0].shading = Shading::TexturedPhong;                                                 
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_x) {
+                state.rasterMode = state.rasterMode == RasterMode::Scanline ? RasterMode::HalfSpace : RasterMode::Scanline;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_c) {
+                state.guardBand = !state.guardBand;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_v) {
+                state.lazyVertexShading = !state.lazyVertexShading;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_d) {
+                state.deferredShading = !state.deferredShading;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_z) {
+                state.zPrepass = !state.zPrepass;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_k) {
+                state.clusterSort = !state.clusterSort;
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_b) {
+                ++state.benchmarkRequests; // Run by the render thread, which owns the renderer
+            } else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_i) {
+                ++state.statsRequests;
             }
         }
 
 
 
-        from = SDL_GetTicks();
-        renderer.drawScene(scene, zNear, zFar, viewAngle, back);
+        // The render thread took the last snapshot and is drawing it: queue the next one, one animation step later
+        if (renderThread.ready()) {
+            renderThread.publish(state);
+
+            // Update rotation angles.
+            state.solids[0].position.xAngle += 0.5f;
+            state.solids[0].position.yAngle += 1.0f;
+        }
+
+        // Present the latest finished frame, if a new one came
+        if (!scene.acquireFrame()) {
+            SDL_Delay(1);
+            continue;
+        }
         to = SDL_GetTicks();
 
         auto durationMs = std::chrono::duration<double, std::milli>(to - from).count();
-        double smoothedMs = frameTimeAvg.update(durationMs);
+        double smoothedMs = frameTimeAvg.update(durationMs); // Time between presented frames
+        from = to;
 
         std::ostringstream oss;
-        oss << "pos: (" << std::fixed << std::setprecision(2) << scene.camera.pos.x
-            << "," << std::fixed << std::setprecision(2) << scene.camera.pos.y
-            << "," << std::fixed << std::setprecision(2) << scene.camera.pos.z
-            << ") " << shadingToString(scene.solids[0]->shading)
+        oss << "pos: (" << std::fixed << std::setprecision(2) << state.camera.pos.x
+            << "," << std::fixed << std::setprecision(2) << state.camera.pos.y
+            << "," << std::fixed << std::setprecision(2) << state.camera.pos.z
+            << ") " << shadingToString(state.solids[0].shading)
+            << " " << rasterModeToString(state.rasterMode)
             << " frames/s: " << std::fixed << std::setprecision(2) << 1000/smoothedMs;
         std::string title = oss.str();
         SDL_SetWindowTitle(window, title.c_str());        
 
-        SDL_Texture* tex = SDL_CreateTextureFromSurface(sdlRenderer, scene.sdlSurface);
-        SDL_RenderCopy(sdlRenderer, tex, nullptr, nullptr);
-        SDL_DestroyTexture(tex);
+        SDL_UpdateTexture(frameTexture, nullptr, scene.frontPixels(), scene.screen.width * sizeof(uint32_t));
+        SDL_RenderCopy(sdlRenderer, frameTexture, nullptr, nullptr);
         SDL_RenderPresent(sdlRenderer);
-
-        // Update rotation angles.
-        scene.solids[0]->position.xAngle += 0.5f;
-        scene.solids[0]->position.yAngle += 1.0f;
     }
 
     // Free resources.
+    renderThread.stop();
     delete[] back;
 
+    SDL_DestroyTexture(frameTexture);
     SDL_DestroyRenderer(sdlRenderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
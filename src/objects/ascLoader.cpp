@@ -14,6 +14,8 @@ void AscLoader::setup(const std::string& filename) {
     loadFaces();
     calculateNormals();
     calculateVertexNormals();
+    buildVertexSoA(); // Loaded meshes can be large, let them use the batch vertex stage
+    buildFaceClusters();
 }
 
 void AscLoader::loadVertices(const std::string& filename) {
@@ -38,13 +40,13 @@ void AscLoader::loadVertices(const std::string& filename) {
     material.Kd = { properties.k_d * 0x00, properties.k_d * 0x58, properties.k_d * 0xfc }; 
     material.Ks = { properties.k_s * 0x00, properties.k_s * 0x58, properties.k_s * 0xfc };
     material.Ns = properties.shininess;
-    materials.insert({"blue", material});
+    int blue = addMaterial("blue", material);
 
     material.Ka = { properties.k_a * 0xff, properties.k_a * 0xff, properties.k_a * 0xff };
     material.Kd = { properties.k_d * 0xff, properties.k_d * 0xff, properties.k_d * 0xff };
     material.Ks = { properties.k_s * 0xff, properties.k_s * 0xff, properties.k_s * 0xff };
     material.Ns = properties.shininess;
-    materials.insert({"white", material});          
+    addMaterial("white", material);          
 
     while (std::getline(file, line)) {
         // Remove leading/trailing spaces
@@ -98,7 +100,7 @@ void AscLoader::loadVertices(const std::string& filename) {
                     faceData.face.vertex1 = std::stoi(match[1]);
                     faceData.face.vertex2 = std::stoi(match[2]);
                     faceData.face.vertex3 = std::stoi(match[3]);
-                    faceData.face.materialKey = "blue"; // Default material key
+                    faceData.face.materialId = blue; // Default material
                     faces.push_back(faceData);
                 }
             }
@@ -82,13 +82,13 @@ void Cube::loadFaces() {
     material.Ks = { properties.k_s * 0xff, properties.k_s * 0xff, properties.k_s * 0xff };
     material.Ns = properties.shininess;
     material.map_Kd = DecodePng(std::string(RES_PATH + mtlPath).c_str());
-    materials.insert({materialKey, material});
+    int materialId = addMaterial(materialKey, material);
 
     // Each face has 2 triangles, so for each face we generate 6 indices
     for (int baseIndex = 0; baseIndex < 6*6; baseIndex += 6) {
 
-        FaceData face1 { .face = { baseIndex + 0, baseIndex + 1, baseIndex + 2, materialKey} };
-        FaceData face2 { .face = { baseIndex + 3, baseIndex + 4, baseIndex + 5, materialKey} };
+        FaceData face1 { .face = { baseIndex + 0, baseIndex + 1, baseIndex + 2, materialId} };
+        FaceData face2 { .face = { baseIndex + 3, baseIndex + 4, baseIndex + 5, materialId} };
         this->faceData.push_back(face1);
         this->faceData.push_back(face2);
     }
@@ -36,6 +36,65 @@ void Solid::calculateVertexNormals() {
 
 }
 
+void Solid::buildVertexSoA() {
+
+    int padded = (numVertices + VERTEX_BATCH - 1) / VERTEX_BATCH * VERTEX_BATCH;
+    for (auto* channel : { &vertexSoA.x, &vertexSoA.y, &vertexSoA.z, &vertexSoA.nx, &vertexSoA.ny, &vertexSoA.nz, &vertexSoA.u, &vertexSoA.v }) {
+        channel->assign(padded, 0.0f);
+    }
+
+    for (int i = 0; i < numVertices; i++) {
+        const VertexData& vData = Solid::vertexData[i];
+        vertexSoA.x[i] = vData.vertex.x;
+        vertexSoA.y[i] = vData.vertex.y;
+        vertexSoA.z[i] = vData.vertex.z;
+        vertexSoA.nx[i] = vData.normal.x;
+        vertexSoA.ny[i] = vData.normal.y;
+        vertexSoA.nz[i] = vData.normal.z;
+        vertexSoA.u[i] = vData.texCoord.x;
+        vertexSoA.v[i] = vData.texCoord.y;
+    }
+    vertexSoA.count = numVertices;
+}
+
+void Solid::buildFaceClusters() {
+
+    // Loaders emit faces in mesh order, so consecutive faces are close to each other and a run makes a compact cluster
+    faceClusters.clear();
+    const int faces = static_cast<int>(faceData.size());
+    for (int first = 0; first < faces; first += FACE_CLUSTER) {
+        int count = std::min(FACE_CLUSTER, faces - first);
+        slib::vec3 center({0, 0, 0});
+        for (int i = first; i < first + count; i++) {
+            const Face& face = faceData[i].face;
+            center += vertexData[face.vertex1].vertex + vertexData[face.vertex2].vertex + vertexData[face.vertex3].vertex;
+        }
+        center /= 3.0f * count;
+        faceClusters.push_back({first, count, center});
+    }
+}
+
+int Solid::addMaterial(const std::string& name, const slib::material& material) {
+
+    auto [it, inserted] = materialIds.insert({name, static_cast<int>(materials.size())});
+    if (inserted) {
+        materials.push_back(material);
+        materialNames.push_back(name);
+    }
+    return it->second;
+}
+
+void Solid::updateTransform() {
+
+    slib::mat4 rotate = smath::rotation(slib::vec3({pos.xAngle, pos.yAngle, pos.zAngle}));
+    slib::mat4 translate = smath::translation(slib::vec3({pos.x, pos.y, pos.z}));
+    slib::mat4 scale = smath::scale(slib::vec3({pos.zoom, pos.zoom, pos.zoom}));
+
+    modelMat = translate * rotate * scale;
+    normalMat = rotate;
+    transformDirty = false;
+}
+
 // Function returning MaterialProperties struct
 MaterialProperties Solid::getMaterialProperties(MaterialType type) {
     switch (type) {
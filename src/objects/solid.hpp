@@ -2,8 +2,11 @@
 #include <cstdint>
 #include <vector>
 #include <map>
+#include <string>
+#include <type_traits>
 #include "../slib.hpp"
 #include "../constants.hpp"
+#include "../vertexBatch.hpp"
 
 enum class Shading {
     Flat,
@@ -36,12 +39,13 @@ struct VertexData {
     slib::vec2 texCoord;
 };
 
+// Plain index record: the three vertices and the entry of Solid::materials used by the face.
 typedef struct Face
 {
     int vertex1;
     int vertex2;
     int vertex3;
-    std::string materialKey;
+    int materialId;
 } Face;
 
 struct FaceData {
@@ -49,6 +53,15 @@ struct FaceData {
     slib::vec3 faceNormal;
 };
 
+static_assert(std::is_trivially_copyable_v<FaceData>, "Faces are copied in bulk by the raster stages");
+
+// Run of consecutive faces and the object space center of their vertices, see Solid::buildFaceClusters().
+struct FaceCluster {
+    int first;
+    int count;
+    slib::vec3 center;
+};
+
 typedef struct Position
 {
     float x;
@@ -58,6 +71,8 @@ typedef struct Position
     float xAngle;
     float yAngle;
     float zAngle;    
+
+    bool operator==(const Position&) const = default;
 } Position;
 
 enum class MaterialType {
@@ -83,8 +98,11 @@ public:
     std::vector<VertexData> vertexData;
     std::vector<FaceData> faceData;
     Shading shading;
-    Position position;
-    std::map<std::string, slib::material> materials;
+    std::vector<slib::material> materials;  // Material table, indexed by Face::materialId
+    std::vector<std::string> materialNames; // Name of each material of the table, same index
+    std::map<std::string, int> materialIds; // Id of each named material, only needed while building the faces
+    VertexSoA vertexSoA; // Optional copy of vertexData for the batch vertex stage, see buildVertexSoA()
+    std::vector<FaceCluster> faceClusters; // Optional, lets the rasterizer draw large meshes roughly front to back
 
     int numVertices;
     int numFaces;
@@ -110,6 +128,43 @@ public:
 
     virtual void calculateVertexNormals();
 
+    // Copies positions, normals and texture coordinates into vertexSoA. Call again if vertexData changes.
+    void buildVertexSoA();
+
+    // Splits faceData into clusters of FACE_CLUSTER consecutive faces. Call again if faceData changes.
+    void buildFaceClusters();
+
+    // Placement of the solid in the world. The non-const access marks the cached matrices for rebuild.
+    Position& position() {
+        transformDirty = true;
+        return pos;
+    }
+
+    const Position& position() const {
+        return pos;
+    }
+
+    // Replaces the placement; the cached matrices are only marked for rebuild when it actually changes.
+    void setPosition(const Position& p) {
+        if (p == pos) return;
+        pos = p;
+        transformDirty = true;
+    }
+
+    // Model (translate * rotate * scale) and normal (rotate) matrices, only rebuilt after the position changed.
+    const slib::mat4& modelMatrix() {
+        if (transformDirty) updateTransform();
+        return modelMat;
+    }
+
+    const slib::mat4& normalMatrix() {
+        if (transformDirty) updateTransform();
+        return normalMat;
+    }
+
+    // Appends a material to the table and returns its id. A name already in the table keeps its material and id.
+    int addMaterial(const std::string& name, const slib::material& material);
+
     virtual MaterialProperties getMaterialProperties(MaterialType type);
 
     virtual int getColorFromMaterial(const float color);
@@ -120,6 +175,14 @@ protected:
     // Protected virtual methods to be implemented by derived classes.
     virtual void loadVertices() = 0;
     virtual void loadFaces() = 0;
+
+private:
+    Position pos{};
+    slib::mat4 modelMat;
+    slib::mat4 normalMat;
+    bool transformDirty = true;
+
+    void updateTransform();
 };
 
 
@@ -35,36 +35,36 @@ void Test::loadFaces() {
     material.Kd = { properties.k_d * 0x00, properties.k_d * 0x58, properties.k_d * 0xfc }; 
     material.Ks = { properties.k_s * 0x00, properties.k_s * 0x58, properties.k_s * 0xfc };
     material.Ns = properties.shininess;
-    materials.insert({"blue", material});
+    int blue = addMaterial("blue", material);
 
     material.Ka = { properties.k_a * 0xff, properties.k_a * 0xff, properties.k_a * 0xff };
     material.Kd = { properties.k_d * 0xff, properties.k_d * 0xff, properties.k_d * 0xff };
     material.Ks = { properties.k_s * 0xff, properties.k_s * 0xff, properties.k_s * 0xff };
     material.Ns = properties.shininess;
-    materials.insert({"white", material});
+    int white = addMaterial("white", material);
 
     face.face.vertex1 = 0+4;
     face.face.vertex2 = 1+4;
     face.face.vertex3 = 2+4;
-    face.face.materialKey = "blue";
+    face.face.materialId = blue;
     faces.push_back(face);
 
     face.face.vertex1 = 0+4;
     face.face.vertex2 = 2+4;
     face.face.vertex3 = 3+4;
-    face.face.materialKey = "white";
+    face.face.materialId = white;
     faces.push_back(face);
 
     face.face.vertex1 = 0;
     face.face.vertex2 = 1;
     face.face.vertex3 = 2;
-    face.face.materialKey = "blue";
+    face.face.materialId = blue;
     faces.push_back(face);
 
     face.face.vertex1 = 0;
     face.face.vertex2 = 2;
     face.face.vertex3 = 3;
-    face.face.materialKey = "white";
+    face.face.materialId = white;
     faces.push_back(face);
 
     this->faceData = faces;
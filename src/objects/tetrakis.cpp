@@ -43,13 +43,13 @@ void Tetrakis::loadFaces() {
     material.Kd = { properties.k_d * 0x00, properties.k_d * 0x58, properties.k_d * 0xfc }; 
     material.Ks = { properties.k_s * 0x00, properties.k_s * 0x58, properties.k_s * 0xfc };
     material.Ns = properties.shininess;
-    materials.insert({"blue", material});
+    int blue = addMaterial("blue", material);
 
     material.Ka = { properties.k_a * 0xff, properties.k_a * 0xff, properties.k_a * 0xff };
     material.Kd = { properties.k_d * 0xff, properties.k_d * 0xff, properties.k_d * 0xff };
     material.Ks = { properties.k_s * 0xff, properties.k_s * 0xff, properties.k_s * 0xff };
     material.Ns = properties.shininess;
-    materials.insert({"white", material});    
+    int white = addMaterial("white", material);    
 
     // Define the quadrilaterals (outer vertices) and centers for each face group.
     const uint16_t quads[6][4] = {
@@ -75,9 +75,9 @@ void Tetrakis::loadFaces() {
             face.face.vertex3 = centers[i];
 
             if (j % 2 == 0) {
-                face.face.materialKey = "blue";
+                face.face.materialId = blue;
             } else {
-                face.face.materialKey = "white";
+                face.face.materialId = white;
             }
 
             faces.push_back(face);
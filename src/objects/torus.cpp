@@ -60,7 +60,7 @@ void Torus::loadFaces(int uSteps, int vSteps) {
     material.Ns = properties.shininess;
     material.map_Kd = DecodePng(std::string(RES_PATH + mtlPath).c_str());
     material.map_Kd.textureFilter = slib::TextureFilter::NEIGHBOUR;
-    materials.insert({"blue", material});
+    int blue = addMaterial("blue", material);
 
     material.Ka = { properties.k_a * 0x00, properties.k_a * 0x00, properties.k_a * 0x00 };
     material.Kd = { properties.k_d * 0xff, properties.k_d * 0xff, properties.k_d * 0xff };
@@ -68,7 +68,7 @@ void Torus::loadFaces(int uSteps, int vSteps) {
     material.Ns = properties.shininess;
     material.map_Kd = DecodePng(std::string(RES_PATH + mtlPath).c_str());
     material.map_Kd.textureFilter = slib::TextureFilter::NEIGHBOUR;
-    materials.insert({"white", material});  
+    int white = addMaterial("white", material);  
 
     int faceIndex = 0;
     for (int i = 0; i < uSteps; i++) {
@@ -85,13 +85,13 @@ void Torus::loadFaces(int uSteps, int vSteps) {
             face.face.vertex1 = idx0;
             face.face.vertex2 = idx1; // wrap-around for the quad
             face.face.vertex3 = idx2;
-            face.face.materialKey = "blue";
+            face.face.materialId = blue;
             faces.push_back(face);
 
             face.face.vertex1 = idx0;
             face.face.vertex2 = idx2; // wrap-around for the quad
             face.face.vertex3 = idx3;
-            face.face.materialKey = "white";
+            face.face.materialId = white;
             faces.push_back(face);
         }
     }
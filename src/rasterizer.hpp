@@ -3,6 +3,8 @@
 #include <iostream>
 #include <cstdint>
 #include <cmath>
+#include <algorithm>
+#include <utility>
 #include "objects/tetrakis.hpp"
 #include "objects/torus.hpp"
 #include "objects/test.hpp"
@@ -13,14 +15,58 @@
 #include "slib.hpp"
 #include "smath.hpp"
 #include "tri.hpp"
+#include "halfspace.hpp"
+#include "stats.hpp"
+#include "alignedAllocator.hpp"
+#include "visibilityBuffer.hpp"
+#include "varyings.hpp"
+#include "kernels/kernels.hpp"
+#include "effects/DepthEffect.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 enum class ClipPlane {
     Left, Right, Bottom, Top, Near, Far
 };
 
+// Raster backend used to fill the set up triangles.
+enum class RasterMode {
+    Scanline,   // Slope stepping along the edges, one scanline at a time
+    HalfSpace   // Edge functions tested on blocks of 8 pixels, attributes from barycentric gradients
+};
+
+inline std::string rasterModeToString(RasterMode m) {
+    switch (m) {
+        case RasterMode::Scanline: return "<Scanline>";
+        case RasterMode::HalfSpace: return "<HalfSpace>";
+        default: return "Unknown";
+    }
+}
+
+static_assert(TILE_SIZE % ZBuffer::COARSE == 0, "Coarse zBuffer tiles must not straddle raster tiles");
+
+// Screen rectangle [x0, x1) x [y0, y1) owned by a single worker during the raster stage.
+struct Tile {
+    int x0, y0, x1, y1;
+};
+
+/*
+Rasterizer<DepthEffect> is the depth-only specialization used by the Z-prepass: the pipeline up to the triangle setup
+is shared with the shading rasterizers, so the triangles are the same, but the raster loops only compute and test
+depth. No attribute is interpolated and no pixel shader runs.
+*/
 template<class Effect>
 class Rasterizer {
     public:
+        static constexpr bool DEPTH_ONLY = std::is_same_v<Effect, DepthEffect>;
+        static constexpr unsigned VARYINGS = Effect::VARYINGS; // Attributes stepped by the raster loops, see varyings.hpp
+        // The pixel shader also takes a VaryingPacket and shades PIXEL_PACKET pixels per call, see ShadePixel()
+        static constexpr bool PACKET_SHADING = requires(const typename Effect::PixelShader& ps, const VaryingPacket& packet, const Scene& scn,
+                                                        Triangle<typename Effect::Vertex>& tri, uint32_t* colors) {
+            ps(packet, 0, scn, tri, colors);
+        };
+
         Rasterizer() :  fullTransformMat(smath::identity()), 
                         normalTransformMat(smath::identity()),
                         viewMatrix(smath::identity())
@@ -30,84 +76,466 @@ class Rasterizer {
             setRenderable(&solid);
             scene = &scn;
             prepareRenderable();
+            if (lazyVertexShading) CullBackFaces();
+            if (clusterSort) SortFaceClusters(); else faceOrder.clear();
             ProcessVertex();
             DrawFaces();
         }
 
+        RasterMode rasterMode = RasterMode::Scanline;
+        bool guardBand = true; // Skip side clipping for triangles that stay inside the guard band
+        bool lazyVertexShading = true; // Cull backfaces in object space first and only shade the vertices still used
+        bool deferredShading = false;  // Raster to the visibility buffer and shade in resolveRow() instead
+        int visibilitySlot = 0;        // Tags the ids this rasterizer writes to the visibility buffer
+        bool depthEqual = false;       // Main pass after a Z-prepass: only fragments at the depth already stored get through
+        bool clusterSort = false;      // Bin the face clusters of the solid nearest first, see SortFaceClusters()
+        FrameStats stats;
+
+        // Forgets the triangles kept for the deferred shading pass of the previous frame.
+        void clearDeferred() {
+            deferredTriangles.clear();
+            deferredSetup.clear();
+        }
+
+        /*
+        Deferred shading pass for one row: every pixel the visibility buffer gives to one of this rasterizer's triangles
+        is shaded exactly once. The vertex attributes are rebuilt from the triangle and the stored barycentric weights at
+        the start of each run of pixels of the same triangle, then stepped along the run like in the raster pass.
+        Rows are independent so the caller can spread them over threads.
+        */
+        void resolveRow(int y) {
+            if (deferredTriangles.empty()) return;
+
+            auto* pixels = scene->pixels();
+            const auto& visibility = *scene->visibilityBuffer;
+            const int hy = y * scene->screen.width;
+            uint32_t runId = VisibilityBuffer::EMPTY;
+            vertex v;
+            PixelPacket packet;
+            uint64_t shaded = 0;
+
+            for (int x = 0; x < scene->screen.width; ++x) {
+                uint32_t id = visibility.Id(hy + x);
+                if (VisibilityBuffer::Slot(id) != visibilitySlot) {
+                    runId = VisibilityBuffer::EMPTY;
+                    continue;
+                }
+
+                uint32_t index = id & VisibilityBuffer::INDEX_MASK;
+                auto& tri = deferredTriangles[index];
+                const auto& setup = deferredSetup[index];
+                if (id == runId) {
+                    addVaryings<VARYINGS>(v, setup.dvdx);
+                } else {
+                    const auto& w = visibility.At(hy + x);
+                    v = tri.p1 + setup.d21 * w.w1 + setup.d31 * w.w2;
+                    runId = id;
+                }
+                if constexpr (!DEPTH_ONLY) ShadePixel(hy + x, v, tri, pixels, packet);
+                ++shaded;
+            }
+            ShadePacket(packet, pixels);
+
+            #pragma omp atomic
+            stats.shadedPixels += shaded;
+        }
+
     private:
         typedef typename Effect::Vertex vertex;
-        std::vector<std::unique_ptr<vertex>> projectedPoints;
+        static constexpr int PARALLEL_VERTEX_BATCHES = 256; // Below this many batches the vertex stage stays on one thread
+        static constexpr int SMALL_TRIANGLE_PIXELS = 8;     // Triangles with at most this many pixel centers in their bounding box take drawSmall()
+        static constexpr int MAX_CLIP_VERTICES = 9; // Each of the 6 planes adds at most one vertex to a triangle
+        static constexpr uint8_t FRUSTUM_CODES = 0x3f;      // Bits of the six ClipPlane values
+        static constexpr uint8_t OUTSIDE_GUARD_BAND = 0x40; // Outcode bit set when the point is beyond the guard band
+        static constexpr int SUBPIXEL_HALF = SUBPIXEL_SCALE / 2;
+        // Edge functions are clamped to this after setup. Over the pixels of one tile they move by less than half of it,
+        // so their sign never changes and the 32 bit values of CoverageBlock8 cannot overflow.
+        static constexpr int64_t EDGE_CLAMP = int64_t(1) << 30;
+        static_assert(int64_t(2 * GUARD_BAND) * SUBPIXEL_SCALE * SUBPIXEL_SCALE * (2 * TILE_SIZE + 8) < EDGE_CLAMP,
+                      "Edge functions could overflow over a tile, lower SUBPIXEL_BITS or GUARD_BAND");
+
+        // Index of the first pixel whose center is at or after the fixed point screen coordinate v.
+        static int FirstCenter(int32_t v) { return (v + SUBPIXEL_HALF - 1) >> SUBPIXEL_BITS; }
+
+        // Pixels whose center may be inside a set up triangle, [minX, maxX] x [minY, maxY].
+        struct PixelBounds {
+            int minX, maxX, minY, maxY;
+            bool empty() const { return minX > maxX || minY > maxY; }
+            int area() const { return (maxX - minX + 1) * (maxY - minY + 1); }
+        };
+
+        static PixelBounds Bounds(const Triangle<vertex>& tri) {
+            return {
+                FirstCenter(std::min({tri.p1.p_x, tri.p2.p_x, tri.p3.p_x})),
+                FirstCenter(std::max({tri.p1.p_x, tri.p2.p_x, tri.p3.p_x})) - 1,
+                FirstCenter(tri.p1.p_y), // Vertices are ordered by y
+                FirstCenter(tri.p3.p_y) - 1
+            };
+        }
+
+        // Rounded divisions for a positive divisor.
+        static int64_t FloorDiv(int64_t a, int64_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+        static int64_t CeilDiv(int64_t a, int64_t b) { return -FloorDiv(-a, b); }
+
+        // What the deferred shading pass needs to rebuild the attributes of a triangle from barycentric weights.
+        struct DeferredSetup {
+            BarycentricPlanes planes;
+            vertex d21, d31; // p2 - p1 and p3 - p1
+            vertex dvdx;     // Step of the attributes per pixel along a row
+
+            explicit DeferredSetup(const Triangle<vertex>& tri) :
+                planes(ToPixels(tri.p1.p_x), ToPixels(tri.p1.p_y), ToPixels(tri.p2.p_x), ToPixels(tri.p2.p_y), ToPixels(tri.p3.p_x), ToPixels(tri.p3.p_y)),
+                d21(tri.p2 - tri.p1),
+                d31(tri.p3 - tri.p1),
+                dvdx(d21 * planes.a1 + d31 * planes.a2)
+            {}
+
+            static float ToPixels(int32_t v) { return v / static_cast<float>(SUBPIXEL_SCALE); }
+        };
+
+        // Pixels of one triangle that passed the depth test and wait to be shaded together, lane i going to index[i].
+        struct PixelPacket {
+            VaryingPacket varyings{}; // Lanes past count are still shaded, keep them finite
+            int index[PIXEL_PACKET];
+            int count = 0;
+            Triangle<vertex>* tri = nullptr;
+        };
+
+        // Polygon being clipped, kept on the stack.
+        struct ClipPolygon {
+            vertex v[MAX_CLIP_VERTICES];
+            int count = 0;
+        };
+
+        std::vector<vertex, AlignedAllocator<vertex>> projectedPoints; // Post-transform vertices, capacity kept across frames and solids
+        std::vector<uint8_t> outCodes; // Bit per ClipPlane set when the projected point is outside that plane
+        std::vector<uint8_t> faceVisible; // Per face, set by the backface pre-pass when it faces the camera
+        std::vector<uint8_t> vertexUsed;  // Per vertex, set by the backface pre-pass when a visible face uses it
+        std::vector<int> faceOrder;       // Faces in binning order when the clusters are sorted, empty for mesh order
+        std::vector<std::pair<float, int>> clusterDepth; // View space distance and index of each face cluster
         Solid* solid;  // Pointer to the abstract Solid
         Scene* scene; // Pointer to the Scene
         slib::mat4 fullTransformMat;
         slib::mat4 normalTransformMat;
         slib::mat4 viewMatrix;
         Effect effect;    
+        std::vector<std::vector<Triangle<vertex>>> threadTriangles; // Set up triangles produced by each thread
+        std::vector<std::vector<Triangle<vertex>*>> tileBins;       // Triangles overlapping each tile, in face order
+        std::vector<Triangle<vertex>> deferredTriangles;            // Deferred shading: triangles of the frame, indexed by id
+        std::vector<DeferredSetup> deferredSetup;                   // Deferred shading: setup of deferredTriangles, same index
+        int tilesX = 0;
+        int tilesY = 0;
         
         void setRenderable(Solid* solidPtr) {
-            projectedPoints.clear();
             projectedPoints.resize(solidPtr->numVertices);
             solid = solidPtr;
         }
 
+        // The model and normal matrices are cached by the solid, the view matrix is set once per frame by the Renderer.
         void prepareRenderable() {
-            slib::mat4 rotate = smath::rotation(slib::vec3({solid->position.xAngle, solid->position.yAngle, solid->position.zAngle}));
-            slib::mat4 translate = smath::translation(slib::vec3({solid->position.x, solid->position.y, solid->position.z}));
-            slib::mat4 scale = smath::scale(slib::vec3({solid->position.zoom, solid->position.zoom, solid->position.zoom}));
-            //slib::mat4 viewMatrix = smath::view(scene->camera.eye, scene->camera.target, scene->camera.up);
-            viewMatrix = smath::fpsview(scene->camera.pos, scene->camera.pitch, scene->camera.yaw);
-
-            float pitch = scene->camera.pitch * RAD;
-            float yaw = scene->camera.yaw * RAD;
-            float cosPitch = cos(pitch);
-            float sinPitch = sin(pitch);
-            float cosYaw = cos(yaw);
-            float sinYaw = sin(yaw);
-            slib::vec3 zaxis = {sinYaw * cosPitch, -sinPitch, cosPitch * cosYaw};
-
-            scene->camera.forward = zaxis;
-
-            fullTransformMat = translate * rotate * scale;
-            normalTransformMat = rotate;
+            fullTransformMat = solid->modelMatrix();
+            normalTransformMat = solid->normalMatrix();
+            viewMatrix = scene->viewMatrix;
         }
 
         void ProcessVertex()
         {
             projectedPoints.resize(solid->numVertices);
-        
-            std::transform(
-                solid->vertexData.begin(),
-                solid->vertexData.end(),
-                projectedPoints.begin(),
-                [&](const auto& vData) {
-                    return effect.vs(vData, fullTransformMat, viewMatrix, normalTransformMat, *scene);
+            outCodes.resize(solid->numVertices);
+
+            // Limits in ndc of the guard band: points inside it stay within GUARD_BAND pixels of the screen origin
+            float guardX = 2.0f * GUARD_BAND / scene->screen.width - 1.0f;
+            float guardY = 2.0f * GUARD_BAND / scene->screen.height - 1.0f;
+
+            if (solid->vertexSoA.size() == solid->numVertices) {
+                ProcessVertexBatch(guardX, guardY);
+                return;
+            }
+
+            // The vertex shader writes straight into the buffer, nothing is allocated per vertex
+            #pragma omp parallel for schedule(static)
+            for (int i = 0; i < solid->numVertices; ++i) {
+                if (lazyVertexShading && !vertexUsed[i]) continue;
+                effect.vs(solid->vertexData[i], fullTransformMat, viewMatrix, normalTransformMat, *scene, projectedPoints[i]);
+                outCodes[i] = OutCode(projectedPoints[i], guardX, guardY);
+            }
+        }
+
+        /*
+        Batch vertex stage for solids with a VertexSoA: VERTEX_BATCH vertices per iteration go from object space to world
+        and clip space in one pass with the model, view and projection matrices combined (the view space position is not
+        produced). Large meshes are split among the threads.
+        */
+        void ProcessVertexBatch(float guardX, float guardY)
+        {
+            const int numVertices = solid->numVertices;
+            const int batches = (numVertices + VERTEX_BATCH - 1) / VERTEX_BATCH;
+            const BatchMatrices matrices(fullTransformMat, scene->viewProjectionMatrix, normalTransformMat);
+
+            #pragma omp parallel for schedule(static) if(batches >= PARALLEL_VERTEX_BATCHES)
+            for (int b = 0; b < batches; ++b) {
+                TransformedVertex transformed[VERTEX_BATCH];
+                int first = b * VERTEX_BATCH;
+                int count = std::min(VERTEX_BATCH, numVertices - first);
+                if (lazyVertexShading && std::none_of(&vertexUsed[first], &vertexUsed[first] + count, [](uint8_t used) { return used; })) {
+                    continue;
+                }
+                kernels().transformVertexBatch(solid->vertexSoA, first, matrices, transformed);
+
+                for (int i = 0; i < count; ++i) {
+                    if (lazyVertexShading && !vertexUsed[first + i]) continue;
+                    effect.vs(transformed[i], *scene, projectedPoints[first + i]);
+                    outCodes[first + i] = OutCode(projectedPoints[first + i], guardX, guardY);
                 }
-            );
+            }
         }
 
+        /*
+        Backface pre-pass of lazy vertex shading. The camera is brought into object space with the inverse of the model
+        matrix (translate * rotate * scale, the rotation being orthonormal its inverse is its transpose), so each face can
+        be tested against its untransformed normal before any vertex is shaded. For a positive zoom this is the same test
+        as Visible(). The vertices of the faces that survive are marked for the vertex stage.
+        */
+        void CullBackFaces() {
+            const Position& position = std::as_const(*solid).position();
+            slib::vec3 translation({fullTransformMat.data[0][3], fullTransformMat.data[1][3], fullTransformMat.data[2][3]});
+            slib::vec3 eye;
+            eye = slib::vec4(scene->camera.pos - translation, 0) * normalTransformMat; // Row vector times R is R^T * v
+            eye /= position.zoom;
+
+            const int numFaces = static_cast<int>(solid->faceData.size());
+            faceVisible.resize(numFaces);
+            uint64_t culled = 0;
+
+            #pragma omp parallel for schedule(static) reduction(+:culled)
+            for (int i = 0; i < numFaces; ++i) {
+                const auto& faceDataEntry = solid->faceData[i];
+                slib::vec3 viewDir = eye - solid->vertexData[faceDataEntry.face.vertex1].vertex;
+                faceVisible[i] = smath::dot(faceDataEntry.faceNormal, viewDir) > 0.0f;
+                culled += !faceVisible[i];
+            }
+
+            // Faces share vertices, so the marking stays on one thread
+            vertexUsed.assign(solid->numVertices, 0);
+            int used = 0;
+            for (int i = 0; i < numFaces; ++i) {
+                if (!faceVisible[i]) continue;
+                const auto& face = solid->faceData[i].face;
+                for (int v : { face.vertex1, face.vertex2, face.vertex3 }) {
+                    used += !vertexUsed[v];
+                    vertexUsed[v] = 1;
+                }
+            }
+
+            stats.backfaceCulled += culled;
+            stats.skippedVertices += solid->numVertices - used;
+        }
+
+        /*
+        Coarse front-to-back order inside a large mesh: the face clusters of the solid are sorted by the view space
+        distance of their center and faceOrder lists the faces cluster by cluster, so the near surfaces reach the zBuffer
+        first and hide more of the far ones. Clusters with the same distance keep their mesh order, and the prepass and
+        the shading pass sort the same way, so the result stays deterministic.
+        */
+        void SortFaceClusters() {
+            const auto& clusters = solid->faceClusters;
+            faceOrder.clear();
+            if (clusters.empty()) return;
+
+            clusterDepth.clear();
+            for (int c = 0; c < static_cast<int>(clusters.size()); ++c) {
+                slib::vec4 world = fullTransformMat * slib::vec4(clusters[c].center, 1);
+                slib::vec3 view = slib::vec3({world.x, world.y, world.z}) * viewMatrix;
+                clusterDepth.push_back({-view.z, c}); // The camera looks down -z
+            }
+            std::sort(clusterDepth.begin(), clusterDepth.end());
+
+            faceOrder.reserve(solid->faceData.size());
+            for (const auto& [depth, c] : clusterDepth) {
+                for (int i = clusters[c].first; i < clusters[c].first + clusters[c].count; ++i) {
+                    faceOrder.push_back(i);
+                }
+            }
+        }
+
+        /*
+        Faces are drawn in two stages so that no two threads ever touch the same pixel or zBuffer entry.
+        - Binning: faces are culled, clipped and set up in parallel. Each thread appends to its own list;
+          with a static schedule every thread gets a contiguous run of faces in thread order, so walking
+          the lists in thread order gives back the face order (mesh order, or faceOrder). Triangles are then sorted into
+          the TILE_SIZE x TILE_SIZE screen tiles their bounding box overlaps.
+        - Raster: every worker takes whole tiles and draws their triangles scissored to the tile.
+        The result is deterministic and does not depend on the number of threads.
+        */
         void DrawFaces() {
+            BinFaces();
+            DrawTiles();
+        }
+
+        void BinFaces() {
+
+            threadTriangles.resize(maxThreads());
+            for (auto& triangles : threadTriangles) triangles.clear();
+
+            uint64_t accepted = 0, rejected = 0, clipped = 0, guardBanded = 0, culled = 0, subpixel = 0;
+            const uint8_t nearFar = PlaneBit(ClipPlane::Near) | PlaneBit(ClipPlane::Far);
+
+            #pragma omp parallel for schedule(static) reduction(+:accepted, rejected, clipped, guardBanded, culled, subpixel)
+            for (int k = 0; k < static_cast<int>(solid->faceData.size()); ++k) {
+                const int i = faceOrder.empty() ? k : faceOrder[k];
+                // Already counted by the pre-pass, and its vertices may not have been shaded
+                if (lazyVertexShading && !faceVisible[i]) continue;
 
-            #pragma omp parallel for
-            for (int i = 0; i < static_cast<int>(solid->faceData.size()); ++i) {
                 const auto& faceDataEntry = solid->faceData[i];
                 const auto& face = faceDataEntry.face;
+
+                // All three points outside the same plane: nothing of the face can be seen
+                uint8_t codes[3] = { outCodes[face.vertex1], outCodes[face.vertex2], outCodes[face.vertex3] };
+                if (codes[0] & codes[1] & codes[2] & FRUSTUM_CODES) {
+                    ++rejected;
+                    continue;
+                }
+
                 slib::vec3 rotatedFaceNormal;
                 rotatedFaceNormal = normalTransformMat * slib::vec4(faceDataEntry.faceNormal, 0);
             
                 Triangle<vertex> tri(
-                    *projectedPoints[face.vertex1],
-                    *projectedPoints[face.vertex2],
-                    *projectedPoints[face.vertex3],
-                    face,
+                    projectedPoints[face.vertex1],
+                    projectedPoints[face.vertex2],
+                    projectedPoints[face.vertex3],
                     rotatedFaceNormal,
-                    solid->materials.at(face.materialKey)
+                    solid->materials[face.materialId]
                 );
             
-                if (Visible(tri)) {
-                    ClipCullDrawTriangleSutherlandHodgman(tri); // Must be thread-safe!
+                if (!lazyVertexShading && !Visible(tri)) {
+                    ++culled;
+                    continue;
+                }
+
+                auto& triangles = threadTriangles[threadNum()];
+                uint8_t planes = codes[0] | codes[1] | codes[2];
+                if (planes == 0) {
+                    ++accepted;
+                    if (SetupTriangle(tri)) triangles.push_back(tri); else ++subpixel;
+                } else if (guardBand && !(planes & (nearFar | OUTSIDE_GUARD_BAND))) {
+                    // Only crosses the screen sides: the raster stage scissors it to the tiles
+                    ++guardBanded;
+                    if (SetupTriangle(tri)) triangles.push_back(tri); else ++subpixel;
+                } else {
+                    ++clipped;
+                    subpixel += ClipCullDrawTriangleSutherlandHodgman(tri, planes, triangles);
                 }
             }
-        
+
+            stats.trivialAccepted += accepted;
+            stats.trivialRejected += rejected;
+            stats.clipped += clipped;
+            stats.guardBanded += guardBanded;
+            stats.backfaceCulled += culled;
+            stats.subpixelCulled += subpixel;
+
+            tilesX = (scene->screen.width + TILE_SIZE - 1) / TILE_SIZE;
+            tilesY = (scene->screen.height + TILE_SIZE - 1) / TILE_SIZE;
+            tileBins.resize(tilesX * tilesY);
+            for (auto& bin : tileBins) bin.clear();
+
+            if (DEPTH_ONLY || !deferredShading) {
+                for (auto& triangles : threadTriangles) {
+                    for (auto& tri : triangles) {
+                        BinTriangle(tri);
+                    }
+                }
+                return;
+            }
+
+            // The visibility buffer refers to triangles by index until the end of the frame, so they are kept there
+            size_t first = deferredTriangles.size();
+            for (auto& triangles : threadTriangles) {
+                for (auto& tri : triangles) {
+                    deferredTriangles.push_back(tri);
+                    deferredSetup.emplace_back(tri);
+                }
+            }
+            for (size_t i = first; i < deferredTriangles.size(); ++i) {
+                BinTriangle(deferredTriangles[i]);
+            }
+        }
+
+        void BinTriangle(Triangle<vertex>& tri) {
+            PixelBounds b = Bounds(tri);
+            if (b.maxX < 0 || b.minX >= scene->screen.width || b.maxY < 0 || b.minY >= scene->screen.height) return;
+            int tx0 = std::clamp(b.minX / TILE_SIZE, 0, tilesX - 1);
+            int tx1 = std::clamp(b.maxX / TILE_SIZE, 0, tilesX - 1);
+            int ty0 = std::clamp(b.minY / TILE_SIZE, 0, tilesY - 1);
+            int ty1 = std::clamp(b.maxY / TILE_SIZE, 0, tilesY - 1);
+
+            int area = b.area();
+            ++stats.triangleSizes[FrameStats::sizeBucket(area)];
+            if (area <= SMALL_TRIANGLE_PIXELS) ++stats.smallTriangles;
+
+            for (int ty = ty0; ty <= ty1; ++ty) {
+                for (int tx = tx0; tx <= tx1; ++tx) {
+                    tileBins[ty * tilesX + tx].push_back(&tri);
+                }
+            }
+        }
+
+        void DrawTiles() {
+
+            uint64_t written = 0;
+
+            #pragma omp parallel for schedule(dynamic) reduction(+:written)
+            for (int t = 0; t < tilesX * tilesY; ++t) {
+                auto& bin = tileBins[t];
+                if (bin.empty()) continue;
+
+                int tx = t % tilesX;
+                int ty = t / tilesX;
+                Tile tile = {
+                    tx * TILE_SIZE,
+                    ty * TILE_SIZE,
+                    std::min((tx + 1) * TILE_SIZE, static_cast<int>(scene->screen.width)),
+                    std::min((ty + 1) * TILE_SIZE, static_cast<int>(scene->screen.height))
+                };
+
+                PixelPacket packet;
+                for (auto* tri : bin) {
+                    PixelBounds bounds = Bounds(*tri);
+                    if (bounds.area() <= SMALL_TRIANGLE_PIXELS) {
+                        written += drawSmall(*tri, tile, bounds, packet);
+                        continue;
+                    }
+                    if (rasterMode == RasterMode::HalfSpace) {
+                        written += drawHalfSpace(*tri, tile, packet);
+                        continue;
+                    }
+                    written += draw(*tri, tile, packet);
+                }
+                ShadePacket(packet, scene->pixels());
+            }
+
+            // Pixels that passed the depth test; in deferred shading they are counted when resolved instead
+            if (DEPTH_ONLY) {
+                stats.prepassPixels += written;
+            } else if (!deferredShading) {
+                stats.shadedPixels += written;
+            }
+        }
+
+        static int maxThreads() {
+#ifdef _OPENMP
+            return omp_get_max_threads();
+#else
+            return 1;
+#endif
+        }
+
+        static int threadNum() {
+#ifdef _OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif
         }
 
         /*
@@ -139,55 +567,88 @@ class Rasterizer {
         If a vertex is inside, it is added to the output polygon. If a vertex is outside, the algorithm checks if the previous vertex was inside. If it was, the edge between the two vertices is clipped and the intersection point is added to the output polygon.
         The algorithm continues until all edges have been processed.
         https://en.wikipedia.org/wiki/Sutherland%E2%80%93Hodgman_algorithm
+        Outcodes are computed once per projected point. Faces whose points share an outside plane are rejected and faces
+        with no outside plane skip the clipper; the rest are clipped only against the planes some point is outside of.
+        The polygon ping-pongs between two fixed size buffers on the stack, so no memory is allocated.
+        With guardBand on, faces that only cross the left, right, top or bottom planes are not clipped as long as their
+        points stay inside the guard band, where screen coordinates are still safe for the fixed point and edge function
+        math; the raster stage scissors them to the screen tiles. The near and far planes are always clipped geometrically.
         */
 
-        void ClipCullDrawTriangleSutherlandHodgman(const Triangle<vertex>& t) {
-            std::vector<vertex> polygon = { t.p1, t.p2, t.p3 };
+        // Returns the number of fan triangles dropped by SetupTriangle.
+        int ClipCullDrawTriangleSutherlandHodgman(const Triangle<vertex>& t, uint8_t planes, std::vector<Triangle<vertex>>& out) {
+            ClipPolygon buffers[2];
+            ClipPolygon* polygon = &buffers[0];
+            ClipPolygon* clippedPolygon = &buffers[1];
+            polygon->v[0] = t.p1;
+            polygon->v[1] = t.p2;
+            polygon->v[2] = t.p3;
+            polygon->count = 3;
 
             for (ClipPlane plane : {ClipPlane::Left, ClipPlane::Right, ClipPlane::Bottom, 
                                     ClipPlane::Top, ClipPlane::Near, ClipPlane::Far}) {
-                polygon = ClipAgainstPlane(polygon, plane);
-                if (polygon.empty()) return; // Completely outside
-            }
-
-            // Triangulate fan-style and draw
-            for (size_t i = 1; i + 1 < polygon.size(); ++i) {
-                Triangle<vertex> tri(polygon[0], polygon[i], polygon[i + 1], t.face, t.faceNormal, t.material);
-                draw(tri,
-                    [&](const vertex from, const vertex to, int num_steps)
-                    {
-                        // Retrieve X coordinates for begin and end.
-                        // Number of steps = number of scanlines
-                        return Slope( from, to, num_steps );
-                    } 
-                );
+                // Points added by other planes lie between the original ones, so they cannot cross a plane none of those crossed
+                if (!(planes & PlaneBit(plane))) continue;
+                ClipAgainstPlane(*polygon, *clippedPolygon, plane);
+                if (clippedPolygon->count == 0) return 0; // Completely outside
+                std::swap(polygon, clippedPolygon);
             }
+
+            // Triangulate fan-style and queue for binning
+            int dropped = 0;
+            for (int i = 1; i + 1 < polygon->count; ++i) {
+                Triangle<vertex> tri(polygon->v[0], polygon->v[i], polygon->v[i + 1], t.faceNormal, t.material);
+                if (SetupTriangle(tri)) {
+                    out.push_back(tri);
+                } else {
+                    ++dropped;
+                }
+            }
+            return dropped;
         }
 
-        std::vector<vertex> ClipAgainstPlane(const std::vector<vertex>& poly, ClipPlane plane) {
-            std::vector<vertex> output;
-            if (poly.empty()) return output;
+        void ClipAgainstPlane(const ClipPolygon& poly, ClipPolygon& output, ClipPlane plane) {
+            output.count = 0;
+            if (poly.count == 0) return;
         
-            vertex prev = poly.back();
-            bool prevInside = IsInside(prev, plane);
+            const vertex* prev = &poly.v[poly.count - 1];
+            bool prevInside = IsInside(*prev, plane);
         
-            for (const auto& curr : poly) {
+            for (int i = 0; i < poly.count; ++i) {
+                const vertex& curr = poly.v[i];
                 bool currInside = IsInside(curr, plane);
         
                 if (currInside != prevInside) {
-                    float alpha = ComputeAlpha(prev, curr, plane);
-                    output.push_back(prev + (curr - prev) * alpha);
+                    float alpha = ComputeAlpha(*prev, curr, plane);
+                    output.v[output.count++] = *prev + (curr - *prev) * alpha;
                 }
         
                 if (currInside)
-                    output.push_back(curr);
+                    output.v[output.count++] = curr;
         
-                prev = curr;
+                prev = &curr;
                 prevInside = currInside;
             }
-        
-            return output;
         } 
+
+        static uint8_t PlaneBit(ClipPlane plane) {
+            return static_cast<uint8_t>(1 << static_cast<int>(plane));
+        }
+
+        // Cohen-Sutherland style outcode: one bit per plane the point is outside of (the negation of IsInside),
+        // plus OUTSIDE_GUARD_BAND when x or y are beyond the guard band limits.
+        static uint8_t OutCode(const vertex& v, float guardX, float guardY) {
+            const auto& p = v.ndc;
+            uint8_t code = 0;
+            if (std::abs(p.x) > guardX * p.w || std::abs(p.y) > guardY * p.w) code |= OUTSIDE_GUARD_BAND;
+            if (p.x < -p.w) code |= PlaneBit(ClipPlane::Left);
+            if (p.x >  p.w) code |= PlaneBit(ClipPlane::Right);
+            if (p.y < -p.w) code |= PlaneBit(ClipPlane::Bottom);
+            if (p.y >  p.w) code |= PlaneBit(ClipPlane::Top);
+            if (p.z < -p.w) code |= PlaneBit(ClipPlane::Near);
+            if (p.z >  p.w) code |= PlaneBit(ClipPlane::Far);
+            return code;
+        }
         
         bool IsInside(const vertex& v, ClipPlane plane) {
             const auto& p = v.ndc;
@@ -205,7 +666,7 @@ class Rasterizer {
         float ComputeAlpha(const vertex& a, const vertex& b, ClipPlane plane) {
             const auto& pa = a.ndc;
             const auto& pb = b.ndc;
-            float num, denom;
+            float num = 0.0f, denom = 0.0f;
         
             switch (plane) {
                 case ClipPlane::Left:
@@ -230,90 +691,443 @@ class Rasterizer {
         The algorithm works by iterating through each scanline of the triangle and determining the left and right edges of the triangle at that scanline.
         For each scanline, the algorithm calculates the x-coordinates of the left and right edges of the triangle and fills in the pixels between them.
         The algorithm uses a slope to determine the x-coordinates of the left and right edges of the triangle at each scanline.
+        Vertices are in fixed point with SUBPIXEL_BITS of fraction and coverage is sampled at pixel centers with the
+        top-left rule: a center exactly on a left or top edge is inside, on a right or bottom edge it is outside, so a
+        pixel on an edge shared by two triangles is drawn once. Depth and the varyings come from plane equations set up
+        once per triangle, see ScanlinePlanes, so the edges only carry x. Only the scanlines and pixels inside the given
+        tile are drawn; the slopes start at the first scanline of the tile.
         */
 
+        /*
+        Edge from a to b, a above b. getx() is the first pixel whose center is at or right of the edge on the current
+        scanline: a left edge starts its span there and a right edge ends it there, the pixel itself being left out.
+        x is stepped exactly with an integer quotient and remainder, so two triangles sharing the edge always agree on it.
+        */
         class Slope
         {
-            vertex begin, step;
+            int x;
+            int64_t r;    // x * den - num, in [0, den), num / den being the exact position in pixels minus half a pixel
+            int64_t den;
+            int64_t q, s; // num grows by q * den + s per scanline, 0 <= s < den
         public:
             Slope() {}
-            Slope(vertex from, vertex to, int num_steps)
+            Slope(const vertex& a, const vertex& b, int y) // y: first scanline
+            {
+                int64_t dx = b.p_x - a.p_x, dy = b.p_y - a.p_y;
+                int64_t centerY = static_cast<int64_t>(y) * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+                int64_t num = (a.p_x - SUBPIXEL_HALF) * dy + dx * (centerY - a.p_y);
+                den = dy * SUBPIXEL_SCALE;
+                x = static_cast<int>(CeilDiv(num, den));
+                r = x * den - num;
+                q = FloorDiv(dx * SUBPIXEL_SCALE, den);
+                s = dx * SUBPIXEL_SCALE - q * den;
+            }
+            int getx() const { return x; }
+            void advance()
             {
-                float inv_step = 1.f / num_steps;
-                begin = from;                   // Begin here
-                step  = (to - from) * inv_step; // Stepsize = (end-begin) / num_steps
+                x += static_cast<int>(q);
+                r -= s;
+                if (r < 0) { ++x; r += den; }
             }
-            vertex get() const { return begin; }
-            int getx() const { return begin.p_x >> 16; }
-            void advance()    { begin += step; }
         };
 
-        void draw(Triangle<vertex>& tri, auto&& MakeSlope) {
+        /*
+        Depth and varyings of a triangle as planes in screen space, v(x, y) = v0 + dvdx * (x - x0) + dvdy * (y - y0),
+        with v0 the value at the center of the pixel (x0, y0) holding the first vertex, so that they keep their precision
+        far from the origin. The scanlines evaluate them at their first pixel center and step along x, with no division
+        and no whole vertex arithmetic per scanline.
+        Textured effects already carry u/w, v/w and 1/w, so their texture coordinates stay perspective correct.
+        */
+        struct ScanlinePlanes {
+            int x0, y0;
+            float z0, dzdx, dzdy;
+            vertex v0, dvdx, dvdy;
+        };
+
+        // Returns false for degenerate triangles, which cover no pixel.
+        bool SetupPlanes(const Triangle<vertex>& tri, ScanlinePlanes& planes) {
+            int64_t dx2 = tri.p2.p_x - tri.p1.p_x, dy2 = tri.p2.p_y - tri.p1.p_y;
+            int64_t dx3 = tri.p3.p_x - tri.p1.p_x, dy3 = tri.p3.p_y - tri.p1.p_y;
+            int64_t area = dx2 * dy3 - dx3 * dy2;
+            if (area == 0) return false;
+
+            // Gradients per pixel: the fixed point deltas are in 1 / SUBPIXEL_SCALE of a pixel
+            float invArea = SUBPIXEL_SCALE / static_cast<float>(area);
+            float ax = dy3 * invArea, bx = -dy2 * invArea; // dvdx = ax * (v2 - v1) + bx * (v3 - v1)
+            float ay = -dx3 * invArea, by = dx2 * invArea; // dvdy = ay * (v2 - v1) + by * (v3 - v1)
+            float dz21 = tri.p2.p_z - tri.p1.p_z, dz31 = tri.p3.p_z - tri.p1.p_z;
+
+            // From the first vertex to the center of its pixel, in pixels
+            planes.x0 = tri.p1.p_x >> SUBPIXEL_BITS;
+            planes.y0 = tri.p1.p_y >> SUBPIXEL_BITS;
+            float ox = (planes.x0 * SUBPIXEL_SCALE + SUBPIXEL_HALF - tri.p1.p_x) / static_cast<float>(SUBPIXEL_SCALE);
+            float oy = (planes.y0 * SUBPIXEL_SCALE + SUBPIXEL_HALF - tri.p1.p_y) / static_cast<float>(SUBPIXEL_SCALE);
+
+            planes.dzdx = ax * dz21 + bx * dz31;
+            planes.dzdy = ay * dz21 + by * dz31;
+            planes.z0 = tri.p1.p_z + planes.dzdx * ox + planes.dzdy * oy;
+            if constexpr (!DEPTH_ONLY) {
+                vertex d31;
+                stepVaryings<VARYINGS>(d31, tri.p1, tri.p3, 1.0f);
+                stepVaryings<VARYINGS>(planes.dvdx, tri.p1, tri.p2, ax);
+                addVaryings<VARYINGS>(planes.dvdx, d31, bx);
+                stepVaryings<VARYINGS>(planes.dvdy, tri.p1, tri.p2, ay);
+                addVaryings<VARYINGS>(planes.dvdy, d31, by);
+                planes.v0 = tri.p1;
+                addVaryings<VARYINGS>(planes.v0, planes.dvdx, ox);
+                addVaryings<VARYINGS>(planes.v0, planes.dvdy, oy);
+            }
+            return true;
+        }
+
+        /*
+        Projects the vertices to screen space and runs the geometry shader.
+        Returns false for triangles whose bounding box holds no pixel center: they cannot cover a pixel, and dense meshes
+        seen from afar have a lot of them, so they are dropped before the geometry shader and the binning.
+        */
+        bool SetupTriangle(Triangle<vertex>& tri) {
 
-            auto* pixels = static_cast<uint32_t*>(scene->sdlSurface->pixels);
             effect.vs.viewProjection(*scene, tri.p1);
             effect.vs.viewProjection(*scene, tri.p2);
             effect.vs.viewProjection(*scene, tri.p3);
             orderVertices(&tri.p1, &tri.p2, &tri.p3);
-            if(tri.p1.p_y == tri.p3.p_y) return;
-
-            bool shortside = (tri.p2.p_y - tri.p1.p_y) * (tri.p3.p_x - tri.p1.p_x) < (tri.p2.p_x - tri.p1.p_x) * (tri.p3.p_y - tri.p1.p_y); // false=left side, true=right side
+            if (Bounds(tri).empty()) return false;
 
             effect.gs(tri, *scene);
+            return true;
+        }
+
+        // Returns the number of pixels that passed the depth test.
+        int draw(Triangle<vertex>& tri, const Tile& tile, PixelPacket& packet) {
 
-            tri.p1.p_x = tri.p1.p_x << 16; // shift to 16.16 space
-            tri.p2.p_x = tri.p2.p_x << 16; // shift to 16.16 space
-            tri.p3.p_x = tri.p3.p_x << 16; // shift to 16.16 space
+            auto* pixels = scene->pixels();
+            int firsty = std::max(FirstCenter(tri.p1.p_y), tile.y0);
+            int midy = FirstCenter(tri.p2.p_y); // First scanline of the lower half
+            int lasty = std::min(FirstCenter(tri.p3.p_y), tile.y1);
+            if (firsty >= lasty) return 0;
+            ScanlinePlanes planes;
+            if (!SetupPlanes(tri, planes)) return 0;
+            int written = 0;
 
-            std::invoke_result_t<decltype(MakeSlope), vertex, vertex,int> sides[2];
+            int64_t dx2 = tri.p2.p_x - tri.p1.p_x, dy2 = tri.p2.p_y - tri.p1.p_y;
+            int64_t dx3 = tri.p3.p_x - tri.p1.p_x, dy3 = tri.p3.p_y - tri.p1.p_y;
+            bool shortside = dy2 * dx3 < dx2 * dy3; // false=left side, true=right side
 
-            sides[!shortside] = MakeSlope(tri.p1,tri.p3, tri.p3.p_y - tri.p1.p_y);
+            Slope sides[2];
+            sides[!shortside] = Slope(tri.p1, tri.p3, firsty);
 
-            for(auto y = tri.p1.p_y, endy = tri.p1.p_y, hy = y * scene->screen.width; ; ++y)
+            for (int y = firsty, hy = y * scene->screen.width; y < lasty; ++y)
             {
-                if(y >= endy)
-                {
-                    // If y of p2 is reached, the triangle is complete.
-                    if(y >= tri.p3.p_y) break;
-                    // Recalculate slope for short side. The number of lines cannot be zero.
-                    sides[shortside] = std::apply(MakeSlope, (y < tri.p2.p_y) ? std::tuple(tri.p1, tri.p2, (endy=tri.p2.p_y) - tri.p1.p_y)
-                                                                              : std::tuple(tri.p2, tri.p3, (endy=tri.p3.p_y) - tri.p2.p_y) );
+                // Short side for the half holding this scanline. Either half has a pixel center when it is drawn.
+                if (y == firsty || y == midy) {
+                    sides[shortside] = y < midy ? Slope(tri.p1, tri.p2, y) : Slope(tri.p2, tri.p3, y);
                 }
                 // On a single scanline, we go from the left X coordinate to the right X coordinate.
-                DrawScanline(hy, sides[0], sides[1], tri, pixels);
+                written += DrawScanline(y, hy, sides[0].getx(), sides[1].getx(), tri, planes, tile, pixels, packet);
+                sides[0].advance();
+                sides[1].advance();
                 hy += scene->screen.width; 
             }
-
+            return written;
         };
 
+        /*
+        Drawing a triangle with half-space (edge function) rasterization.
+        Every edge defines a linear function that is positive on the inner side of the edge; a pixel is covered when
+        the functions of the three edges are non negative at its center. Pixels on a shared edge go to exactly one
+        triangle using the top-left rule. Coverage is tested 8 pixels at a time with CoverageBlock8, and the
+        attributes are interpolated from the barycentric gradients of the triangle, stepped per pixel and per row.
+        Edge functions are set up in 64 bits from the fixed point vertices, then clamped to 32 bits, see EDGE_CLAMP.
+        Depth is evaluated from its plane equation at every pixel rather than stepped, so that the depth-only prepass,
+        which steps nothing else, gets bit for bit the same values as the main pass.
+        Returns the number of pixels that passed the depth test.
+        */
+        int drawHalfSpace(Triangle<vertex>& tri, const Tile& tile, PixelPacket& packet) {
+
+            auto* pixels = scene->pixels();
+            const vertex* v[3] = { &tri.p1, &tri.p2, &tri.p3 };
+            int x[3] = { tri.p1.p_x, tri.p2.p_x, tri.p3.p_x };
+            int y[3] = { tri.p1.p_y, tri.p2.p_y, tri.p3.p_y };
+
+            int64_t area = static_cast<int64_t>(x[1] - x[0]) * (y[2] - y[0]) - static_cast<int64_t>(y[1] - y[0]) * (x[2] - x[0]);
+            if (area == 0) return 0;
+            if (area < 0) { // Make the inner side positive for every edge
+                std::swap(v[1], v[2]);
+                std::swap(x[1], x[2]);
+                std::swap(y[1], y[2]);
+                area = -area;
+            }
+
+            // Pixels whose center may be inside, clipped to the tile.
+            // Blocks start on a multiple of 8 so that each one lies inside a single coarse zBuffer tile.
+            // Tiles start on such a multiple too, and the extra pixels on the left are outside the triangle.
+            int minX = std::max(FirstCenter(std::min({x[0], x[1], x[2]})), tile.x0) & ~7;
+            int maxX = std::min(FirstCenter(std::max({x[0], x[1], x[2]})), tile.x1) - 1;
+            int minY = std::max(FirstCenter(std::min({y[0], y[1], y[2]})), tile.y0);
+            int maxY = std::min(FirstCenter(std::max({y[0], y[1], y[2]})), tile.y1) - 1;
+            if (minX > maxX || minY > maxY) return 0;
+
+            // Edge k goes from v[k] to v[k+1]: E(p) = (bx-ax)(py-ay) - (by-ay)(px-ax), evaluated at the center of (minX, minY)
+            const int64_t cx = static_cast<int64_t>(minX) * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+            const int64_t cy = static_cast<int64_t>(minY) * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+            int stepX[3], stepY[3], rowStart[3];
+            float weight[3];
+            for (int k = 0; k < 3; ++k) {
+                int64_t ax = x[k], ay = y[k];
+                int64_t bx = x[(k + 1) % 3], by = y[(k + 1) % 3];
+                stepX[k] = static_cast<int>(-(by - ay) * SUBPIXEL_SCALE);
+                stepY[k] = static_cast<int>((bx - ax) * SUBPIXEL_SCALE);
+                int64_t e = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+                weight[k] = static_cast<float>(e) / static_cast<float>(area);
+                bool topLeft = (ay == by && bx > ax) || (by < ay);
+                if (!topLeft) e -= 1; // Pixels exactly on a right or bottom edge are left out
+                rowStart[k] = static_cast<int>(std::clamp<int64_t>(e, -EDGE_CLAMP, EDGE_CLAMP));
+            }
+
+            // Edge 2 (v2->v0) gives the weight of v1 and edge 0 (v0->v1) the weight of v2
+            float invArea = 1.0f / static_cast<float>(area);
+            vertex d10 = *v[1] - *v[0];
+            vertex d20 = *v[2] - *v[0];
+            vertex dvdx = d10 * (stepX[2] * invArea) + d20 * (stepX[0] * invArea);
+            vertex dvdy = d10 * (stepY[2] * invArea) + d20 * (stepY[0] * invArea);
+            vertex dvdx8 = dvdx * 8.0f;
+            vertex vRow = *v[0] + d10 * weight[2] + d20 * weight[0];
+            const float zOrigin = vRow.p_z; // Depth at the center of (minX, minY)
+
+            CoverageBlock8 block(stepX[0], stepX[1], stepX[2]);
+            auto& zBuffer = *scene->zBuffer;
+            int written = 0;
+
+            for (int py = minY; py <= maxY; ++py) {
+                int e0 = rowStart[0], e1 = rowStart[1], e2 = rowStart[2];
+                vertex vBlock = vRow;
+                int hy = py * scene->screen.width;
+                float zRow = zOrigin + dvdy.p_z * (py - minY);
+
+                for (int px = minX; px <= maxX; px += 8) {
+                    int mask = block.mask(e0, e1, e2);
+                    if (maxX - px < 7) mask &= (1 << (maxX - px + 1)) - 1;
+
+                    // The depth is linear along the block, so its nearest value is at one of the ends
+                    float zFirst = zRow + dvdx.p_z * (px - minX);
+                    float zLast = zRow + dvdx.p_z * (px + 7 - minX);
+                    if (mask && !zBuffer.IsOccluded(py, px, px + 1, std::min(zFirst, zLast), depthEqual)) {
+                        bool runWritten = false;
+                        vertex vPixel = vBlock;
+                        for (int i = 0; (mask >> i) != 0; ++i) {
+                            if (mask & (1 << i)) {
+                                int index = hy + px + i;
+                                float z = zRow + dvdx.p_z * (px + i - minX);
+                                if (DepthTest(zBuffer, index, z)) {
+                                    if constexpr (!DEPTH_ONLY) WritePixel(index, px + i + 0.5f, py + 0.5f, vPixel, tri, pixels, packet);
+                                    runWritten = true;
+                                    ++written;
+                                }
+                            }
+                            if constexpr (!DEPTH_ONLY) addVaryings<VARYINGS>(vPixel, dvdx);
+                        }
+                        if (!depthEqual && runWritten) {
+                            zBuffer.MarkWritten(px, py);
+                        }
+                    }
+
+                    e0 += 8 * stepX[0];
+                    e1 += 8 * stepX[1];
+                    e2 += 8 * stepX[2];
+                    if constexpr (!DEPTH_ONLY) addVaryings<VARYINGS>(vBlock, dvdx8);
+                }
+
+                rowStart[0] += stepY[0];
+                rowStart[1] += stepY[1];
+                rowStart[2] += stepY[2];
+                if constexpr (!DEPTH_ONLY) addVaryings<VARYINGS>(vRow, dvdy);
+            }
+            return written;
+        }
+
+        /*
+        Small triangle path, for triangles with at most SMALL_TRIANGLE_PIXELS pixel centers in their bounding box.
+        Each candidate pixel is tested directly against the three edge functions with the same top-left rule as
+        drawHalfSpace, and depth and varyings come from its barycentric weights. None of the slope, plane or block setup
+        of the other paths is paid for the pixel or two such a triangle usually covers.
+        Returns the number of pixels that passed the depth test.
+        */
+        int drawSmall(Triangle<vertex>& tri, const Tile& tile, PixelBounds b, PixelPacket& packet) {
+
+            b.minX = std::max(b.minX, tile.x0);
+            b.maxX = std::min(b.maxX, tile.x1 - 1);
+            b.minY = std::max(b.minY, tile.y0);
+            b.maxY = std::min(b.maxY, tile.y1 - 1);
+            if (b.empty()) return 0;
+
+            auto* pixels = scene->pixels();
+            const vertex* v[3] = { &tri.p1, &tri.p2, &tri.p3 };
+            int64_t x[3] = { tri.p1.p_x, tri.p2.p_x, tri.p3.p_x };
+            int64_t y[3] = { tri.p1.p_y, tri.p2.p_y, tri.p3.p_y };
+            int64_t area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+            if (area == 0) return 0;
+            if (area < 0) { // Make the inner side positive for every edge
+                std::swap(v[1], v[2]);
+                std::swap(x[1], x[2]);
+                std::swap(y[1], y[2]);
+                area = -area;
+            }
+
+            int64_t bias[3];
+            for (int k = 0; k < 3; ++k) {
+                int64_t ax = x[k], ay = y[k], bx = x[(k + 1) % 3], by = y[(k + 1) % 3];
+                bool topLeft = (ay == by && bx > ax) || (by < ay);
+                bias[k] = topLeft ? 0 : 1; // Pixels exactly on a right or bottom edge are left out
+            }
+
+            float invArea = 1.0f / static_cast<float>(area);
+            float dz10 = v[1]->p_z - v[0]->p_z, dz20 = v[2]->p_z - v[0]->p_z;
+            vertex d10, d20;
+            if constexpr (!DEPTH_ONLY) {
+                stepVaryings<VARYINGS>(d10, *v[0], *v[1], 1.0f);
+                stepVaryings<VARYINGS>(d20, *v[0], *v[2], 1.0f);
+            }
+            auto& zBuffer = *scene->zBuffer;
+            int written = 0;
+
+            for (int py = b.minY; py <= b.maxY; ++py) {
+                int64_t cy = static_cast<int64_t>(py) * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+                for (int px = b.minX; px <= b.maxX; ++px) {
+                    int64_t cx = static_cast<int64_t>(px) * SUBPIXEL_SCALE + SUBPIXEL_HALF;
+                    int64_t e[3];
+                    for (int k = 0; k < 3; ++k) {
+                        int k1 = (k + 1) % 3;
+                        e[k] = (x[k1] - x[k]) * (cy - y[k]) - (y[k1] - y[k]) * (cx - x[k]);
+                    }
+                    if (e[0] < bias[0] || e[1] < bias[1] || e[2] < bias[2]) continue;
+
+                    // Edge 2 (v2->v0) gives the weight of v1 and edge 0 (v0->v1) the weight of v2
+                    float w1 = e[2] * invArea, w2 = e[0] * invArea;
+                    float z = v[0]->p_z + dz10 * w1 + dz20 * w2;
+                    int index = py * scene->screen.width + px;
+                    if (!DepthTest(zBuffer, index, z)) continue;
+                    if constexpr (!DEPTH_ONLY) {
+                        vertex vPixel = *v[0];
+                        addVaryings<VARYINGS>(vPixel, d10, w1);
+                        addVaryings<VARYINGS>(vPixel, d20, w2);
+                        WritePixel(index, px + 0.5f, py + 0.5f, vPixel, tri, pixels, packet);
+                    }
+                    if (!depthEqual) zBuffer.MarkWritten(px, py);
+                    ++written;
+                }
+            }
+            return written;
+        }
+
+        // Plain depth test, or the equal test of the main pass when a Z-prepass already filled the zBuffer.
+        inline bool DepthTest(ZBuffer& zBuffer, int index, float z) {
+            return depthEqual ? zBuffer.TestEqual(index, z) : zBuffer.TestAndSet(index, z);
+        }
+
+        /*
+        Final step for a pixel that passed the depth test. In forward mode it is shaded right away; in deferred mode only
+        the triangle and the barycentric weights at the sample point (sx, sy) are recorded, and a later write by a nearer
+        triangle replaces them without any shading having been spent.
+        */
+        inline void WritePixel(int index, float sx, float sy, vertex& v, Triangle<vertex>& tri, uint32_t* pixels, PixelPacket& packet) {
+            if (!deferredShading) {
+                ShadePixel(index, v, tri, pixels, packet);
+                return;
+            }
+            uint32_t triangleIndex = static_cast<uint32_t>(&tri - deferredTriangles.data());
+            const BarycentricPlanes& planes = deferredSetup[triangleIndex].planes;
+            scene->visibilityBuffer->Write(index, VisibilityBuffer::MakeId(visibilitySlot, triangleIndex), planes.W1(sx, sy), planes.W2(sx, sy));
+        }
+
+        /*
+        Shades one pixel. With a packet pixel shader the pixel only joins the packet, which is shaded once it is full or
+        when a pixel of another triangle comes; the caller shades what is left with ShadePacket() at the end. Writes to
+        the framebuffer keep the order of the calls, since a packet is always shaded before the next one starts.
+        */
+        inline void ShadePixel(int index, vertex& v, Triangle<vertex>& tri, uint32_t* pixels, PixelPacket& packet) {
+            if constexpr (PACKET_SHADING) {
+                if (packet.tri != &tri) {
+                    ShadePacket(packet, pixels);
+                    packet.tri = &tri;
+                }
+                storeVaryings<VARYINGS>(packet.varyings, packet.count, v);
+                packet.index[packet.count] = index;
+                if (++packet.count == PIXEL_PACKET) ShadePacket(packet, pixels);
+            } else {
+                pixels[index] = effect.ps(v, *scene, tri);
+            }
+        }
+
+        inline void ShadePacket(PixelPacket& packet, uint32_t* pixels) {
+            if constexpr (PACKET_SHADING) {
+                if (packet.count == 0) return;
+                alignas(32) uint32_t colors[PIXEL_PACKET];
+                effect.ps(packet.varyings, (1 << packet.count) - 1, *scene, *packet.tri, colors);
+                for (int i = 0; i < packet.count; ++i) pixels[packet.index[i]] = colors[i];
+                packet.count = 0;
+            }
+        }
+
         inline void orderVertices(vertex *p1, vertex *p2, vertex *p3) {
             if (p1->p_y > p2->p_y) std::swap(*p1,*p2);
             if (p2->p_y > p3->p_y) std::swap(*p2,*p3);
             if (p1->p_y > p2->p_y) std::swap(*p1,*p2);
         };
         
-        inline void DrawScanline(const int& y, Slope& left, Slope& right, Triangle<vertex>& tri, uint32_t* pixels) {
+        /*
+        The span is first tested against the coarse level of the zBuffer with its nearest depth, so hidden spans
+        are skipped before any attribute is interpolated. Visible spans are walked in runs that stay inside one
+        coarse tile, and each run gets the same early test.
+        Depth is evaluated from its plane at every pixel, like in drawHalfSpace, so that it does not depend on which runs
+        were skipped. The depth-only rasterizer runs the same loop without the vertex.
+        Returns the number of pixels that passed the depth test.
+        */
+        inline int DrawScanline(int y, int hy, int xStart, int xEnd, Triangle<vertex>& tri, const ScanlinePlanes& planes, const Tile& tile, uint32_t* pixels, PixelPacket& packet) {
             
-            int xStart = left.getx();
-            int xEnd = right.getx();
-            int dx = xEnd - xStart;
-        
-            if (dx != 0) {
-                float invDx = 1.0f / dx;
-                vertex vStart = left.get();
-                vertex vStep = (right.get() - vStart) * invDx;
-        
-                for (int x = xStart; x < xEnd; ++x) {
-                    int index = y + x;
-                    if (scene->zBuffer->TestAndSet(index, vStart.p_z)) {
-                        pixels[index] = effect.ps(vStart, *scene, tri);
+            int xFrom = std::max(xStart, tile.x0);
+            int xTo = std::min(xEnd, tile.x1);
+            if (xFrom >= xTo) return 0;
+            auto& zBuffer = *scene->zBuffer;
+            int written = 0;
+
+            float zRow = planes.z0 + planes.dzdy * (y - planes.y0);
+            float zFrom = zRow + planes.dzdx * (xFrom - planes.x0);
+            float zTo = zRow + planes.dzdx * (xTo - 1 - planes.x0);
+            if (zBuffer.IsOccluded(y, xFrom, xTo, std::min(zFrom, zTo), depthEqual)) return 0;
+
+            vertex v;
+            if constexpr (!DEPTH_ONLY) {
+                v = planes.v0;
+                addVaryings<VARYINGS>(v, planes.dvdy, static_cast<float>(y - planes.y0));
+                addVaryings<VARYINGS>(v, planes.dvdx, static_cast<float>(xFrom - planes.x0));
+            }
+
+            for (int x = xFrom; x < xTo; ) {
+                int runEnd = std::min(xTo, (x / ZBuffer::COARSE + 1) * ZBuffer::COARSE);
+                float zFirst = zRow + planes.dzdx * (x - planes.x0);
+                float zLast = zRow + planes.dzdx * (runEnd - 1 - planes.x0);
+                if (zBuffer.IsOccluded(y, x, runEnd, std::min(zFirst, zLast), depthEqual)) {
+                    if constexpr (!DEPTH_ONLY) addVaryings<VARYINGS>(v, planes.dvdx, static_cast<float>(runEnd - x));
+                    x = runEnd;
+                    continue;
+                }
+
+                bool runWritten = false;
+                for (; x < runEnd; ++x) {
+                    int index = hy + x;
+                    float z = zRow + planes.dzdx * (x - planes.x0);
+                    if (DepthTest(zBuffer, index, z)) {
+                        if constexpr (!DEPTH_ONLY) WritePixel(index, x + 0.5f, y + 0.5f, v, tri, pixels, packet);
+                        runWritten = true;
+                        ++written;
                     }
-                    vStart += vStep;
+                    if constexpr (!DEPTH_ONLY) addVaryings<VARYINGS>(v, planes.dvdx);
+                }
+                if (!depthEqual && runWritten) {
+                    zBuffer.MarkWritten(runEnd - 1, y);
                 }
             }
-        
-            left.advance();
-            right.advance();
+            return written;
         }
 
     };
@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "tripleBuffer.hpp"
+#include "benchmark.hpp"
+
+/*
+Everything the main thread changes between frames: the camera, the position and shading of each solid and the
+renderer settings. The render thread applies the latest one to its Scene and Renderer before drawing a frame, so
+the main thread never touches them while a frame is in flight.
+Benchmarks and stats dumps are requested by bumping a counter; a counter survives snapshots that replace each other
+before the render thread sees them, where a one shot flag could be lost.
+*/
+struct SceneSnapshot
+{
+    struct SolidState {
+        Position position;
+        Shading shading;
+    };
+
+    Camera camera;
+    std::vector<SolidState> solids; // Same order as Scene::solids
+    RasterMode rasterMode = RasterMode::Scanline;
+    bool guardBand = true;
+    bool lazyVertexShading = true;
+    bool deferredShading = false;
+    bool zPrepass = false;
+    bool clusterSort = false;
+    unsigned benchmarkRequests = 0;
+    unsigned statsRequests = 0;
+
+    static SceneSnapshot capture(const Scene& scene, const Renderer& renderer) {
+        SceneSnapshot s;
+        s.camera = scene.camera;
+        for (const auto& solidPtr : scene.solids) {
+            s.solids.push_back({std::as_const(*solidPtr).position(), solidPtr->shading});
+        }
+        s.rasterMode = renderer.getRasterMode();
+        s.guardBand = renderer.getGuardBand();
+        s.lazyVertexShading = renderer.getLazyVertexShading();
+        s.deferredShading = renderer.getDeferredShading();
+        s.zPrepass = renderer.getZPrepass();
+        s.clusterSort = renderer.getClusterSort();
+        return s;
+    }
+
+    void apply(Scene& scene, Renderer& renderer) const {
+        scene.camera = camera;
+        for (size_t i = 0; i < solids.size() && i < scene.solids.size(); ++i) {
+            scene.solids[i]->setPosition(solids[i].position); // Keeps the cached matrices of solids that did not move
+            scene.solids[i]->shading = solids[i].shading;
+        }
+        // The setters walk every rasterizer, so only settings that changed are passed on
+        if (renderer.getRasterMode() != rasterMode) renderer.setRasterMode(rasterMode);
+        if (renderer.getGuardBand() != guardBand) renderer.setGuardBand(guardBand);
+        if (renderer.getLazyVertexShading() != lazyVertexShading) renderer.setLazyVertexShading(lazyVertexShading);
+        if (renderer.getDeferredShading() != deferredShading) renderer.setDeferredShading(deferredShading);
+        if (renderer.getZPrepass() != zPrepass) renderer.setZPrepass(zPrepass);
+        if (renderer.getClusterSort() != clusterSort) renderer.setClusterSort(clusterSort);
+    }
+};
+
+/*
+Draws frames on its own thread, pipelined with the thread that handles input and presents: while frame N is
+uploaded and shown, frame N + 1 is being drawn, so a frame takes about max(draw, present) instead of their sum.
+Snapshots come in through one TripleBuffer and finished frames go out through the framebuffers of the Scene
+(Scene::acquireFrame()), both lock-free. The thread draws one frame per snapshot and sleeps when there is none.
+After start() the Scene and the Renderer belong to the render thread until stop().
+*/
+class RenderThread {
+
+    public:
+        RenderThread(Renderer& renderer, Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back)
+            : renderer(renderer), scene(scene), zNear(zNear), zFar(zFar), viewAngle(viewAngle), back(back),
+              snapshots(SceneSnapshot::capture(scene, renderer))
+        {}
+        RenderThread(const RenderThread&) = delete;
+
+        ~RenderThread() {
+            stop();
+        }
+
+        void start() {
+            stopping.store(false, std::memory_order_relaxed);
+            thread = std::thread([this] { run(); });
+        }
+
+        void stop() {
+            if (!thread.joinable()) return;
+            stopping.store(true, std::memory_order_release);
+            snapshots.publish(); // Wakes the thread up
+            thread.join();
+        }
+
+        // True once the render thread took the last snapshot, i.e. it is drawing it and wants the next one.
+        bool ready() const {
+            return !snapshots.pending();
+        }
+
+        // Hands a snapshot to the render thread, replacing one it did not take yet.
+        void publish(const SceneSnapshot& snapshot) {
+            snapshots.back() = snapshot;
+            snapshots.publish();
+        }
+
+    private:
+        void run() {
+            unsigned benchmarksDone = 0;
+            unsigned statsDone = 0;
+            while (true) {
+                snapshots.wait();
+                if (stopping.load(std::memory_order_acquire)) break;
+                if (!snapshots.update()) continue;
+
+                const SceneSnapshot& snapshot = snapshots.front();
+                snapshot.apply(scene, renderer);
+                if (snapshot.benchmarkRequests != benchmarksDone) {
+                    benchmarksDone = snapshot.benchmarkRequests;
+                    runRasterBenchmark(renderer, scene, zNear, zFar, viewAngle, back);
+                    runPrepassBenchmark(renderer, scene, zNear, zFar, viewAngle, back);
+                    runKernelBenchmark(renderer, scene, zNear, zFar, viewAngle, back);
+                }
+
+                renderer.drawScene(scene, zNear, zFar, viewAngle, back);
+                scene.swapBuffers();
+
+                if (snapshot.statsRequests != statsDone) {
+                    statsDone = snapshot.statsRequests;
+                    std::cout << renderer.frameStats();
+                }
+            }
+        }
+
+        Renderer& renderer;
+        Scene& scene;
+        float zNear;
+        float zFar;
+        float viewAngle;
+        uint32_t* back;
+        TripleBuffer<SceneSnapshot> snapshots;
+        std::atomic<bool> stopping{false};
+        std::thread thread;
+};
@@ -2,6 +2,10 @@
 #include <SDL2/SDL.h>
 #include <iostream>
 #include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <utility>
 #include "objects/solid.hpp"
 #include "rasterizer.hpp"
 #include "effects/flatEffect.hpp"
@@ -19,44 +23,101 @@ class Renderer {
 
         void drawScene(Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back) {
 
-            prepareFrame(scene, zNear, zFar, viewAngle, back);
-            for (auto& solidPtr : scene.solids) {
-                switch (solidPtr->shading) {
-                    case Shading::Flat: 
-                        flatRasterizer.drawRenderable(*solidPtr, scene);
-                        break;   
-                    case Shading::TexturedFlat: 
-                        texturedFlatRasterizer.drawRenderable(*solidPtr, scene);
-                        break;                             
-                    case Shading::Gouraud: 
-                        gouraudRasterizer.drawRenderable(*solidPtr, scene);
-                        break;
-                    case Shading::TexturedGouraud: 
-                        texturedGouraudRasterizer.drawRenderable(*solidPtr, scene);
-                        break;                        
-                    case Shading::BlinnPhong:
-                        blinnPhongRasterizer.drawRenderable(*solidPtr, scene);
-                        break;  
-                    case Shading::TexturedBlinnPhong:
-                        texturedBlinnPhongRasterizer.drawRenderable(*solidPtr, scene);
-                        break;                                                       
-                    case Shading::Phong:
-                        phongRasterizer.drawRenderable(*solidPtr, scene);
-                        break;      
-                    case Shading::TexturedPhong:
-                        texturedPhongRasterizer.drawRenderable(*solidPtr, scene);
-                        break;                                             
-                    default: flatRasterizer.drawRenderable(*solidPtr, scene);
+            prepareFrame(scene, zNear, zFar, viewAngle);
+            buildRenderQueue(scene);
+            if (zPrepass) {
+                for (const auto& item : renderQueue) {
+                    depthRasterizer.drawRenderable(*item.solid, scene);
                 }
             }
+            for (const auto& item : renderQueue) {
+                drawSolid(*item.solid, scene);
+            }
+            if (deferredShading) resolveVisibility(scene);
+            composeBackground(scene, back);
+        }
+
+        // Selects the raster backend used by every rasterizer of this renderer.
+        void setRasterMode(RasterMode mode) {
+            rasterMode = mode;
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.rasterMode = mode; });
+        }
+
+        RasterMode getRasterMode() const {
+            return rasterMode;
+        }
+
+        // Lets triangles that only cross the screen sides skip the clipper.
+        void setGuardBand(bool enabled) {
+            guardBand = enabled;
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.guardBand = enabled; });
+        }
+
+        bool getGuardBand() const {
+            return guardBand;
+        }
+
+        // Culls backfaces in object space before the vertex stage so that only vertices of visible faces are shaded.
+        void setLazyVertexShading(bool enabled) {
+            lazyVertexShading = enabled;
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.lazyVertexShading = enabled; });
+        }
+
+        bool getLazyVertexShading() const {
+            return lazyVertexShading;
+        }
+
+        // Rasters only depth, triangle and barycentrics, then shades every covered pixel once at the end of the frame.
+        void setDeferredShading(bool enabled) {
+            deferredShading = enabled;
+            int slot = 0;
+            forEachRasterizer([&](auto& rasterizer) {
+                rasterizer.deferredShading = enabled;
+                rasterizer.visibilitySlot = slot++;
+            });
+        }
+
+        bool getDeferredShading() const {
+            return deferredShading;
+        }
+
+        // Fills the zBuffer with a depth-only pass first, so the shading pass only shades the visible fragment of each pixel.
+        void setZPrepass(bool enabled) {
+            zPrepass = enabled;
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.depthEqual = enabled; });
+            depthRasterizer.depthEqual = false; // The prepass itself keeps the nearest depth
+        }
+
+        bool getZPrepass() const {
+            return zPrepass;
+        }
+
+        // Draws the faces of each large mesh cluster by cluster, nearest cluster first.
+        void setClusterSort(bool enabled) {
+            clusterSort = enabled;
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.clusterSort = enabled; });
+        }
+
+        bool getClusterSort() const {
+            return clusterSort;
+        }
+
+        // Counters of the last frame drawn, summed over all the rasterizers.
+        FrameStats frameStats() {
+            FrameStats total;
+            forEachRasterizer([&](auto& rasterizer) { total += rasterizer.stats; });
+            return total;
         }
 
-        void prepareFrame(Scene& scene, float zNear, float zFar, float viewAngle, uint32_t* back) {
+        void prepareFrame(Scene& scene, float zNear, float zFar, float viewAngle) {
 
             //std::fill_n(scene.pixels, scene.screen.width * scene.screen.height, 0);
-            auto* pixels = static_cast<uint32_t*>(scene.sdlSurface->pixels);
-            std::copy(back, back + scene.screen.width * scene.screen.height, pixels);
             scene.zBuffer->Clear(); // Clear the zBuffer
+            forEachRasterizer([&](auto& rasterizer) { rasterizer.stats = FrameStats(); });
+            if (deferredShading) {
+                scene.visibilityBuffer->Clear();
+                forEachRasterizer([&](auto& rasterizer) { rasterizer.clearDeferred(); });
+            }
         
             //float zNear = 0.1f; // Near plane distance
             //float zFar  = 10000.0f; // Far plane distance
@@ -64,6 +125,13 @@ class Renderer {
             float fovRadians = viewAngle * (PI / 180.0f);
         
             scene.projectionMatrix = smath::perspective(zFar, zNear, aspectRatio, fovRadians);
+
+            // The camera is the same for every solid of the frame
+            //scene.viewMatrix = smath::view(scene.camera.eye, scene.camera.target, scene.camera.up);
+            scene.viewMatrix = smath::fpsview(scene.camera.pos, scene.camera.pitch, scene.camera.yaw);
+            scene.viewProjectionMatrix = scene.viewMatrix * scene.projectionMatrix;
+
+            scene.camera.forward = scene.camera.direction();
         }
         
         Rasterizer<FlatEffect> flatRasterizer;
@@ -74,6 +142,125 @@ class Renderer {
         Rasterizer<TexturedGouraudEffect> texturedGouraudRasterizer;
         Rasterizer<TexturedPhongEffect> texturedPhongRasterizer;
         Rasterizer<TexturedBlinnPhongEffect> texturedBlinnPhongRasterizer;
+        Rasterizer<DepthEffect> depthRasterizer;
+
+    private:
+        RasterMode rasterMode = RasterMode::Scanline;
+        bool guardBand = true;
+        bool lazyVertexShading = true;
+        bool deferredShading = false;
+        bool zPrepass = false;
+        bool clusterSort = false;
+
+        // Solid queued for the frame with the keys it is sorted by, see buildRenderQueue().
+        struct RenderItem {
+            Solid* solid;
+            const std::string* material; // Name of its first material (id 0), groups solids drawn with the same one
+            float depth;                 // View space distance of its origin
+        };
+        std::vector<RenderItem> renderQueue; // Capacity kept across frames
+
+        /*
+        Orders the solids of the frame: grouped by shading, so the same rasterizer and its warm buffers run back to back,
+        then by the name of their first material (materials[0]; solids without materials come first), then front to
+        back inside each group, so the near solids fill the zBuffer first and the early depth tests reject more of the
+        far ones. Ties keep the insertion order of the scene.
+        */
+        void buildRenderQueue(Scene& scene) {
+            static const std::string noMaterial;
+            renderQueue.clear();
+            for (auto& solidPtr : scene.solids) {
+                const Position& p = std::as_const(*solidPtr).position();
+                slib::vec3 view = slib::vec3({p.x, p.y, p.z}) * scene.viewMatrix;
+                const std::string* material = solidPtr->materialNames.empty() ? &noMaterial : &solidPtr->materialNames.front();
+                renderQueue.push_back({solidPtr.get(), material, -view.z}); // The camera looks down -z
+            }
+            std::stable_sort(renderQueue.begin(), renderQueue.end(), [](const RenderItem& a, const RenderItem& b) {
+                if (a.solid->shading != b.solid->shading) return a.solid->shading < b.solid->shading;
+                if (int order = a.material->compare(*b.material)) return order < 0;
+                return a.depth < b.depth;
+            });
+        }
+
+        void drawSolid(Solid& solid, Scene& scene) {
+            switch (solid.shading) {
+                case Shading::Flat: 
+                    flatRasterizer.drawRenderable(solid, scene);
+                    break;   
+                case Shading::TexturedFlat: 
+                    texturedFlatRasterizer.drawRenderable(solid, scene);
+                    break;                             
+                case Shading::Gouraud: 
+                    gouraudRasterizer.drawRenderable(solid, scene);
+                    break;
+                case Shading::TexturedGouraud: 
+                    texturedGouraudRasterizer.drawRenderable(solid, scene);
+                    break;                        
+                case Shading::BlinnPhong:
+                    blinnPhongRasterizer.drawRenderable(solid, scene);
+                    break;  
+                case Shading::TexturedBlinnPhong:
+                    texturedBlinnPhongRasterizer.drawRenderable(solid, scene);
+                    break;                                                       
+                case Shading::Phong:
+                    phongRasterizer.drawRenderable(solid, scene);
+                    break;      
+                case Shading::TexturedPhong:
+                    texturedPhongRasterizer.drawRenderable(solid, scene);
+                    break;                                             
+                default: flatRasterizer.drawRenderable(solid, scene);
+            }
+        }
+
+        // Shading pass of deferred shading, rows in parallel. Each rasterizer shades the pixels tagged with its slot.
+        void resolveVisibility(Scene& scene) {
+            #pragma omp parallel for schedule(dynamic, 8)
+            for (int y = 0; y < scene.screen.height; ++y) {
+                forEachRasterizer([&](auto& rasterizer) { rasterizer.resolveRow(y); });
+            }
+        }
+
+        /*
+        Copies the background into the pixels no solid was drawn on, after the geometry instead of under it, so the
+        covered part of the background is never read nor written. The zBuffer tells which pixels are covered: every
+        pixel written this frame passed a depth test. Raster tiles in parallel, each row in runs of uncovered pixels.
+        */
+        void composeBackground(Scene& scene, const uint32_t* back) {
+            auto* pixels = scene.pixels();
+            const ZBuffer& zBuffer = *scene.zBuffer;
+            const int width = scene.screen.width;
+            const int height = scene.screen.height;
+            const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+            const int tiles = tilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+
+            #pragma omp parallel for schedule(dynamic)
+            for (int tile = 0; tile < tiles; ++tile) {
+                const int x0 = (tile % tilesX) * TILE_SIZE;
+                const int y0 = (tile / tilesX) * TILE_SIZE;
+                const int x1 = std::min(x0 + TILE_SIZE, width);
+                const int y1 = std::min(y0 + TILE_SIZE, height);
+                for (int y = y0; y < y1; ++y) {
+                    const int row = y * width;
+                    for (int x = x0; x < x1;) {
+                        int run = zBuffer.CoverageRun(row + x, x1 - x);
+                        if (!zBuffer.Written(row + x)) std::copy_n(back + row + x, run, pixels + row + x);
+                        x += run;
+                    }
+                }
+            }
+        }
+
+        void forEachRasterizer(auto&& fn) {
+            fn(flatRasterizer);
+            fn(gouraudRasterizer);
+            fn(phongRasterizer);
+            fn(blinnPhongRasterizer);
+            fn(texturedFlatRasterizer);
+            fn(texturedGouraudRasterizer);
+            fn(texturedPhongRasterizer);
+            fn(texturedBlinnPhongRasterizer);
+            fn(depthRasterizer);
+        }
 };
 
 
@@ -1,6 +1,6 @@
 #pragma once
-#include <SDL2/SDL.h>
 #include <vector>
+#include <cmath>
 #include <memory>    // for std::unique_ptr
 #include <algorithm> // for std::fill
 #include <cstdint>   // for uint32_t
@@ -9,6 +9,9 @@
 #include "smath.hpp"
 #include "slib.hpp"
 #include "ZBuffer.hpp"
+#include "visibilityBuffer.hpp"
+#include "tripleBuffer.hpp"
+#include "constants.hpp"
 
 
 struct Camera
@@ -21,6 +24,14 @@ struct Camera
     float pitch;
     float yaw;
     slib::vec3 forward;
+
+    // Unit view direction for pitch and yaw, what the Renderer stores in forward each frame.
+    slib::vec3 direction() const
+    {
+        float p = pitch * RAD;
+        float y = yaw * RAD;
+        return {std::sin(y) * std::cos(p), -std::sin(p), std::cos(p) * std::cos(y)};
+    }
 };
 
 typedef struct Screen
@@ -36,21 +47,17 @@ public:
     Scene(const Screen& scr)
         : screen(scr),
           zBuffer( std::make_shared<ZBuffer>( scr.width,scr.height )),
-          projectionMatrix(smath::identity())
+          projectionMatrix(smath::identity()),
+          viewMatrix(smath::identity()),
+          viewProjectionMatrix(smath::identity()),
+          visibilityBuffer( std::make_shared<VisibilityBuffer>( scr.width,scr.height )),
+          framebuffers( std::vector<uint32_t>(static_cast<size_t>(scr.width) * scr.height, 0) )
     {
-        sdlSurface = SDL_CreateRGBSurface(0, screen.width, screen.height, 32, 0, 0, 0, 0);
-        SDL_SetSurfaceBlendMode(sdlSurface, SDL_BLENDMODE_NONE);
         camera.eye = {0.0f, 0.0f, 0.0f};          // Camera position
         camera.target = {0.0f, 0.0f, -1.0f};      // Point to look at (in -Z)
         camera.up = {0.0f, 1.0f, 0.0f};           // Up vector (typically +Y)
     }
 
-    // Destructor to free the allocated memory.
-    ~Scene()
-    {
-        SDL_FreeSurface(sdlSurface);
-    }
-
     // Called to set up the Scene, including creation of Solids, etc.
     void setup();
 
@@ -61,16 +68,52 @@ public:
         solids.push_back(std::move(solid));
     }
 
+    /*
+    The frame is drawn on the CPU into framebuffers (XRGB8888, screen.width pixels per row) handed to the presenting
+    thread through a TripleBuffer: the renderer draws the next frame while the last finished one is uploaded, and
+    neither waits for the other. pixels() and swapBuffers() belong to the drawing thread, acquireFrame() and
+    frontPixels() to the presenting one; both may be the same thread.
+    */
+
+    // Buffer the next frame is drawn into.
+    uint32_t* pixels()
+    {
+        return framebuffers.back().data();
+    }
+
+    // Call once a frame is drawn: hands it to the presenter and moves on to a free buffer.
+    void swapBuffers()
+    {
+        framebuffers.publish();
+    }
+
+    // Takes the latest finished frame into frontPixels(); false when none came since the last call.
+    bool acquireFrame()
+    {
+        return framebuffers.update();
+    }
+
+    // Frame taken by the last acquireFrame(), the one to present.
+    const uint32_t* frontPixels() const
+    {
+        return framebuffers.front().data();
+    }
+
     Screen screen;
    
     slib::vec3 lux;
     slib::vec3 eye;
     slib::vec3 halfwayVector;
     slib::mat4 projectionMatrix;
+    slib::mat4 viewMatrix;           // Camera view matrix, set once per frame by the Renderer
+    slib::mat4 viewProjectionMatrix; // viewMatrix * projectionMatrix
     std::shared_ptr<ZBuffer> zBuffer; // Use shared_ptr for zBuffer to manage its lifetime automatically.
-    SDL_Surface* sdlSurface = nullptr; // SDL surface for rendering.
+    std::shared_ptr<VisibilityBuffer> visibilityBuffer; // Triangle and barycentrics per pixel, used by deferred shading.
 
     Camera camera; // Camera object to manage camera properties.
     // Store solids in a vector of unique_ptr to handle memory automatically.
     std::vector<std::unique_ptr<Solid>> solids;
+
+private:
+    TripleBuffer<std::vector<uint32_t>> framebuffers;
 };
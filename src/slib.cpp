@@ -1,5 +1,8 @@
 #include "slib.hpp"
 #include <iostream>
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
 
 namespace slib
 {
@@ -195,18 +198,16 @@ namespace slib
         return x == rhs && y == rhs && z == rhs;
     }
 
+    // The vector is taken as a point (w = 1) multiplied as a row vector, the resulting w is dropped.
     vec3 vec3::operator*(const mat4& rhs) const
     {
-        mat4 lhs({{this->x, this->y, this->z}});
-        lhs *= rhs;
-        return {lhs.data[0][0], lhs.data[0][1], lhs.data[0][2]};
+        const vec4 result = vec4(*this, 1) * rhs;
+        return {result.x, result.y, result.z};
     }
 
     vec3& vec3::operator*=(const mat4& rhs)
     {
-        mat4 lhs({{this->x, this->y, this->z}});
-        lhs *= rhs;
-        *this = {lhs.data[0][0], lhs.data[0][1], lhs.data[0][2]};
+        *this = *this * rhs;
         return *this;
     }
 
@@ -240,22 +241,11 @@ namespace slib
 
     mat4& mat4::operator+=(const mat4& rhs)
     {
-        const auto rhsrows = rhs.data.size();
-        const auto rhscols = rhs.data.at(0).size();
-        const auto lhsrows = data.size();
-        const auto lhscols = data.at(0).size();
-
-        if (lhscols != rhsrows)
+        for (int row = 0; row < 4; ++row)
         {
-            std::cout << "Error: mat-size mismatch." << std::endl;
-            exit(1);
-        }
-        auto maxCols = lhscols >= rhscols ? lhscols : rhscols;
-        for (int col = 0; col < static_cast<int>(maxCols); ++col)
-        {
-            for (int row = 0; row < static_cast<int>(lhsrows); ++row)
+            for (int col = 0; col < 4; ++col)
             {
-                data[col][row] += rhs.data[col][row];
+                data[row][col] += rhs.data[row][col];
             }
         }
         return *this;
@@ -263,47 +253,84 @@ namespace slib
 
     mat4& mat4::operator*=(const mat4& rhs)
     {
-        mat4 result({{0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0}});
-    
-        for (size_t i = 0; i < 4; ++i)
+        *this = *this * rhs;
+        return *this;
+    }
+
+    mat4 mat4::operator*(const mat4& rhs) const
+    {
+        mat4 result;
+#if defined(__SSE2__)
+        // Row i of the product is the rows of rhs weighted by the elements of row i of this matrix.
+        const __m128 r0 = _mm_load_ps(rhs.data[0]);
+        const __m128 r1 = _mm_load_ps(rhs.data[1]);
+        const __m128 r2 = _mm_load_ps(rhs.data[2]);
+        const __m128 r3 = _mm_load_ps(rhs.data[3]);
+        for (int i = 0; i < 4; ++i)
+        {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(data[i][0]), r0);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(data[i][1]), r1));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(data[i][2]), r2));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(data[i][3]), r3));
+            _mm_store_ps(result.data[i], row);
+        }
+#else
+        for (int i = 0; i < 4; ++i)
         {
-            for (size_t j = 0; j < 4; ++j)
+            for (int j = 0; j < 4; ++j)
             {
-                result.data[i][j] = 0;
-                for (size_t k = 0; k < 4; ++k)
+                for (int k = 0; k < 4; ++k)
                 {
                     result.data[i][j] += data[i][k] * rhs.data[k][j];
                 }
             }
         }
-    
-        data = result.data;
-        return *this;
-    }
-    
-
-    mat4 mat4::operator*(const mat4& rhs) const
-    {
-        mat4 toReturn(data);
-        return toReturn *= rhs;
+#endif
+        return result;
     }
 
     vec4 mat4::operator*(const vec4& v) const
     {
+#if defined(__SSE2__)
+        // Transposing gives the columns, so the result is a weighted sum of columns like in vec4 * mat4.
+        __m128 c0 = _mm_load_ps(data[0]);
+        __m128 c1 = _mm_load_ps(data[1]);
+        __m128 c2 = _mm_load_ps(data[2]);
+        __m128 c3 = _mm_load_ps(data[3]);
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        __m128 res = _mm_mul_ps(c0, _mm_set1_ps(v.x));
+        res = _mm_add_ps(res, _mm_mul_ps(c1, _mm_set1_ps(v.y)));
+        res = _mm_add_ps(res, _mm_mul_ps(c2, _mm_set1_ps(v.z)));
+        res = _mm_add_ps(res, _mm_mul_ps(c3, _mm_set1_ps(v.w)));
+        alignas(16) float out[4];
+        _mm_store_ps(out, res);
+        return vec4{out[0], out[1], out[2], out[3]};
+#else
         float res_x = data[0][0] * v.x + data[0][1] * v.y + data[0][2] * v.z + data[0][3] * v.w;
         float res_y = data[1][0] * v.x + data[1][1] * v.y + data[1][2] * v.z + data[1][3] * v.w;
         float res_z = data[2][0] * v.x + data[2][1] * v.y + data[2][2] * v.z + data[2][3] * v.w;
         float res_w = data[3][0] * v.x + data[3][1] * v.y + data[3][2] * v.z + data[3][3] * v.w;
         return vec4{res_x, res_y, res_z, res_w};
+#endif
     }
 
     vec4 vec4::operator*(const mat4& m) const
     {
+#if defined(__SSE2__)
+        __m128 res = _mm_mul_ps(_mm_load_ps(m.data[0]), _mm_set1_ps(x));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_load_ps(m.data[1]), _mm_set1_ps(y)));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_load_ps(m.data[2]), _mm_set1_ps(z)));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_load_ps(m.data[3]), _mm_set1_ps(w)));
+        alignas(16) float out[4];
+        _mm_store_ps(out, res);
+        return vec4{out[0], out[1], out[2], out[3]};
+#else
         float res_x = m.data[0][0] * (this->x) + m.data[1][0] * this->y + m.data[2][0] * this->z + m.data[3][0] * this->w;
         float res_y = m.data[0][1] * this->x + m.data[1][1] * this->y + m.data[2][1] * this->z + m.data[3][1] * this->w;
         float res_z = m.data[0][2] * this->x + m.data[1][2] * this->y + m.data[2][2] * this->z + m.data[3][2] * this->w;
         float res_w = m.data[0][3] * this->x + m.data[1][3] * this->y + m.data[2][3] * this->z + m.data[3][3] * this->w;
         return vec4{res_x, res_y, res_z, res_w};
+#endif
     }
 
     vec4 vec4::operator*=(const mat4& rhs)
@@ -101,10 +101,24 @@ namespace slib
         }
     };
 
-    struct mat4
+    /*
+    4x4 matrix stored row by row as data[row][col] in a fixed, 16 byte aligned array, so it never touches the heap
+    and each row can be loaded straight into one SSE register.
+    */
+    struct alignas(16) mat4
     {
-        std::vector<std::vector<float>> data;
-        explicit mat4(std::vector<std::vector<float>> _data) : data(std::move(_data)){};
+        float data[4][4];
+
+        constexpr mat4() : data{}
+        {
+        }
+        constexpr mat4(const float m00, const float m01, const float m02, const float m03,
+                       const float m10, const float m11, const float m12, const float m13,
+                       const float m20, const float m21, const float m22, const float m23,
+                       const float m30, const float m31, const float m32, const float m33)
+            : data{{m00, m01, m02, m03}, {m10, m11, m12, m13}, {m20, m21, m22, m23}, {m30, m31, m32, m33}}
+        {
+        }
 
         mat4& operator+=(const mat4& rhs);
         mat4& operator*=(const mat4& rhs);
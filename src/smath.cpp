@@ -63,12 +63,11 @@ namespace smath
         const float xScale = yScale / aspect;
         const float nearmfar = zNear - zFar;
 
-        slib::mat4 mat(
-            {{xScale, 0, 0, 0},
-             {0, yScale, 0, 0},
-             {0, 0, (zFar + zNear) / nearmfar, -1},
-             {0, 0, 2 * zFar * zNear / nearmfar, 0}});
-        return mat;
+        return slib::mat4(
+            xScale, 0, 0, 0,
+            0, yScale, 0, 0,
+            0, 0, (zFar + zNear) / nearmfar, -1,
+            0, 0, 2 * zFar * zNear / nearmfar, 0);
     }
 
     slib::mat4 view(const slib::vec3& eye, const slib::vec3& target, const slib::vec3& up)
@@ -77,13 +76,11 @@ namespace smath
         slib::vec3 xaxis = normalize(cross(up, zaxis));
         slib::vec3 yaxis = cross(zaxis, xaxis);
 
-        slib::mat4 viewMatrix(
-            {{xaxis.x, yaxis.x, zaxis.x, 0},
-             {xaxis.y, yaxis.y, zaxis.y, 0},
-             {xaxis.z, yaxis.z, zaxis.z, 0},
-             {-dot(xaxis, eye), -dot(yaxis, eye), -dot(zaxis, eye), 1}});
-
-        return viewMatrix;
+        return slib::mat4(
+            xaxis.x, yaxis.x, zaxis.x, 0,
+            xaxis.y, yaxis.y, zaxis.y, 0,
+            xaxis.z, yaxis.z, zaxis.z, 0,
+            -dot(xaxis, eye), -dot(yaxis, eye), -dot(zaxis, eye), 1);
     }
 
     slib::mat4 fpsview(const slib::vec3& eye, float pitch, float yaw)
@@ -99,13 +96,11 @@ namespace smath
         slib::vec3 yaxis = {sinYaw * sinPitch, cosPitch, cosYaw * sinPitch};
         slib::vec3 zaxis = {sinYaw * cosPitch, -sinPitch, cosPitch * cosYaw};
 
-        slib::mat4 viewMatrix(
-            {{xaxis.x, yaxis.x, zaxis.x, 0},
-             {xaxis.y, yaxis.y, zaxis.y, 0},
-             {xaxis.z, yaxis.z, zaxis.z, 0},
-             {-dot(xaxis, eye), -dot(yaxis, eye), -dot(zaxis, eye), 1}});
-
-        return viewMatrix;
+        return slib::mat4(
+            xaxis.x, yaxis.x, zaxis.x, 0,
+            xaxis.y, yaxis.y, zaxis.y, 0,
+            xaxis.z, yaxis.z, zaxis.z, 0,
+            -dot(xaxis, eye), -dot(yaxis, eye), -dot(zaxis, eye), 1);
     }
 
     slib::mat4 rotation(const slib::vec3& eulerAngles)
@@ -120,29 +115,28 @@ namespace smath
         const float azc = std::cos(zrad);
         const float azs = -std::sin(zrad);
 
-        slib::mat4 rotateX({{1, 0, 0, 0}, {0, axc, axs, 0}, {0, -axs, axc, 0}, {0, 0, 0, 1}});
+        const slib::mat4 rotateX(1, 0, 0, 0, 0, axc, axs, 0, 0, -axs, axc, 0, 0, 0, 0, 1);
 
-        slib::mat4 rotateY({{ayc, 0, -ays, 0}, {0, 1, 0, 0}, {ays, 0, ayc, 0}, {0, 0, 0, 1}});
+        const slib::mat4 rotateY(ayc, 0, -ays, 0, 0, 1, 0, 0, ays, 0, ayc, 0, 0, 0, 0, 1);
 
-        slib::mat4 rotateZ({{azc, azs, 0, 0}, {-azs, azc, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}});
+        const slib::mat4 rotateZ(azc, azs, 0, 0, -azs, azc, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
 
         return rotateZ * rotateX * rotateY;
     }
 
     slib::mat4 scale(const slib::vec3& scale)
     {
-        return slib::mat4({{scale.x, 0, 0, 0}, {0, scale.y, 0, 0}, {0, 0, scale.z, 0}, {0, 0, 0, 1}});
+        return slib::mat4(scale.x, 0, 0, 0, 0, scale.y, 0, 0, 0, 0, scale.z, 0, 0, 0, 0, 1);
     }
 
     slib::mat4 translation(const slib::vec3& translation)
     {
-        return slib::mat4(
-            {{1, 0, 0, translation.x}, {0, 1, 0, translation.y}, {0, 0, 1, translation.z}, {0, 0, 0, 1}});
+        return slib::mat4(1, 0, 0, translation.x, 0, 1, 0, translation.y, 0, 0, 1, translation.z, 0, 0, 0, 1);
     }
 
     slib::mat4 identity()
     {
-        return slib::mat4({{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}});
+        return slib::mat4(1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
     }
 
     void sampleNearest(const slib::texture& tex, float u, float v, int& r, int& g, int& b)
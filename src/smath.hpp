@@ -4,6 +4,9 @@
 
 #pragma once
 #include "slib.hpp"
+#include "constants.hpp"
+#include <cmath>
+#include <cstdint>
 #include <vector>
 
 
@@ -23,4 +26,7 @@ namespace smath
     slib::mat4 fpsview(const slib::vec3& eye, float pitch, float yaw);
     void sampleNearest(const slib::texture& tex, float u, float v, int& r, int& g, int& b);
     void sampleBilinear(const slib::texture& tex, float u, float v, float& r, float& g, float& b);
+
+    // Screen coordinate in pixels to fixed point with SUBPIXEL_BITS of fraction, rounded to the nearest step.
+    inline int32_t toSubpixel(float v) { return static_cast<int32_t>(std::lrint(v * SUBPIXEL_SCALE)); }
 }; // namespace smath
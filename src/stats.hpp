@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include "kernels/kernels.hpp"
+
+// Counters gathered while drawing a frame. Each rasterizer keeps its own, reset in Renderer::prepareFrame.
+struct FrameStats
+{
+    // Clipper paths taken by the faces of the solids
+    uint64_t trivialAccepted = 0; // All vertices inside the frustum, no clipping
+    uint64_t trivialRejected = 0; // All vertices outside the same plane, dropped
+    uint64_t clipped = 0;         // Went through Sutherland-Hodgman
+    uint64_t guardBanded = 0;     // Crossed only the screen sides and were scissored instead of clipped
+
+    // Culling
+    uint64_t backfaceCulled = 0;  // Faces turned away from the camera
+    uint64_t skippedVertices = 0; // Vertices not shaded because only backfaces use them (lazy vertex shading)
+
+    // Triangles after setup
+    static constexpr int SIZE_BUCKETS = 8;
+    uint64_t subpixelCulled = 0;  // Bounding box holds no pixel center, dropped before the geometry shader
+    uint64_t smallTriangles = 0;  // Drawn by the small triangle path
+    uint64_t triangleSizes[SIZE_BUCKETS] = {}; // Binned triangles by pixel centers in their bounding box, see sizeBucket()
+
+    // Pixels
+    uint64_t shadedPixels = 0;    // Pixel shader runs
+    uint64_t prepassPixels = 0;   // Depth writes of the Z-prepass
+
+    // Histogram bucket for a bounding box of the given number of pixels: 1, up to 4, 16, 64, 256, 1024, 4096, more.
+    static int sizeBucket(int pixels)
+    {
+        int bucket = 0;
+        for (int limit = 1; pixels > limit && bucket < SIZE_BUCKETS - 1; limit *= 4) ++bucket;
+        return bucket;
+    }
+
+    FrameStats& operator+=(const FrameStats& rhs)
+    {
+        trivialAccepted += rhs.trivialAccepted;
+        trivialRejected += rhs.trivialRejected;
+        clipped += rhs.clipped;
+        guardBanded += rhs.guardBanded;
+        backfaceCulled += rhs.backfaceCulled;
+        skippedVertices += rhs.skippedVertices;
+        subpixelCulled += rhs.subpixelCulled;
+        smallTriangles += rhs.smallTriangles;
+        for (int i = 0; i < SIZE_BUCKETS; ++i) triangleSizes[i] += rhs.triangleSizes[i];
+        shadedPixels += rhs.shadedPixels;
+        prepassPixels += rhs.prepassPixels;
+        return *this;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const FrameStats& stats)
+{
+    os << "clipper: accepted " << stats.trivialAccepted
+       << ", rejected " << stats.trivialRejected
+       << ", clipped " << stats.clipped
+       << ", guard band " << stats.guardBanded << "\n"
+       << "culling: backfaces " << stats.backfaceCulled
+       << ", vertices skipped " << stats.skippedVertices << "\n"
+       << "triangles: no pixel center " << stats.subpixelCulled
+       << ", small path " << stats.smallTriangles << ", bounding box pixels";
+    const char* limits[FrameStats::SIZE_BUCKETS] = { "1", "4", "16", "64", "256", "1k", "4k", "more" };
+    for (int i = 0; i < FrameStats::SIZE_BUCKETS; ++i) os << " " << limits[i] << ":" << stats.triangleSizes[i];
+    os << "\n"
+       << "pixels: shaded " << stats.shadedPixels
+       << ", prepass depth writes " << stats.prepassPixels << "\n"
+       << "kernels: " << kernels().name << "\n";
+    return os;
+}
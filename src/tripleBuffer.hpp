@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <array>
+
+/*
+Lock-free handoff of the latest value from one producer thread to one consumer thread. The producer fills back()
+and publish()es it; the consumer takes the most recent published value with update() and reads it in front().
+With three slots neither side ever waits for the other: a value published before the previous one was taken
+simply replaces it, and the consumer keeps reading its front() until something newer comes.
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+    explicit TripleBuffer(const T& initial = T())
+        : slots{initial, initial, initial}
+    {}
+    TripleBuffer(const TripleBuffer&) = delete;
+
+    // Producer side: the slot being filled.
+    T& back() {
+        return slots[backIndex];
+    }
+
+    // Producer side: hands back() to the consumer and goes on with a free slot.
+    void publish() {
+        int previous = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel);
+        backIndex = previous & INDEX;
+        middle.notify_one();
+    }
+
+    // Producer side: true while the last published value was not taken yet.
+    bool pending() const {
+        return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+    }
+
+    // Consumer side: moves the latest published value into front() if one came since the last call.
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+        int previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX;
+        return true;
+    }
+
+    // Consumer side: blocks until something is published that update() has not taken yet.
+    void wait() const {
+        int current = middle.load(std::memory_order_acquire);
+        if ((current & FRESH) == 0) middle.wait(current, std::memory_order_acquire);
+    }
+
+    // Consumer side: the value taken by the last update().
+    T& front() {
+        return slots[frontIndex];
+    }
+
+    const T& front() const {
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr int INDEX = 3; // Slot bits of middle
+    static constexpr int FRESH = 4; // Set in middle when it holds a value the consumer has not taken
+
+    std::array<T, 3> slots;
+    int backIndex = 0;              // Owned by the producer
+    int frontIndex = 1;             // Owned by the consumer
+    std::atomic<int> middle{2};     // Slot in between, swapped by both
+};
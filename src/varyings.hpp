@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+Vertex attributes a pixel shader can read. Every effect lists the ones its pixel shader uses in its VARYINGS mask and
+the raster loops only step those per pixel and per scanline: a Flat vertex carries nothing across a span, a Gouraud
+one only its color. The clipper and the triangle setup still work on whole vertices, since the geometry shader may
+read any attribute. Depth and screen x are not varyings, the raster loops handle them on their own.
+*/
+namespace varying {
+    constexpr unsigned None = 0;
+    constexpr unsigned Normal = 1 << 0;  // slib::vec3 normal
+    constexpr unsigned Tex = 1 << 1;     // slib::zvec2 tex
+    constexpr unsigned Color = 1 << 2;   // Color color
+    constexpr unsigned Diffuse = 1 << 3; // float diffuse
+}
+
+// v += d, for the varyings in MASK only.
+template<unsigned MASK, class V>
+inline void addVaryings(V& v, const V& d)
+{
+    if constexpr ((MASK & varying::Normal) != 0) v.normal += d.normal;
+    if constexpr ((MASK & varying::Tex) != 0) v.tex += d.tex;
+    if constexpr ((MASK & varying::Color) != 0) v.color += d.color;
+    if constexpr ((MASK & varying::Diffuse) != 0) v.diffuse += d.diffuse;
+}
+
+// v += d * n, for the varyings in MASK only.
+template<unsigned MASK, class V>
+inline void addVaryings(V& v, const V& d, float n)
+{
+    if constexpr ((MASK & varying::Normal) != 0) v.normal += d.normal * n;
+    if constexpr ((MASK & varying::Tex) != 0) v.tex += d.tex * n;
+    if constexpr ((MASK & varying::Color) != 0) v.color += d.color * n;
+    if constexpr ((MASK & varying::Diffuse) != 0) v.diffuse += d.diffuse * n;
+}
+
+// step = (to - from) * scale, for the varyings in MASK only.
+template<unsigned MASK, class V>
+inline void stepVaryings(V& step, const V& from, const V& to, float scale)
+{
+    if constexpr ((MASK & varying::Normal) != 0) step.normal = (to.normal - from.normal) * scale;
+    if constexpr ((MASK & varying::Tex) != 0) step.tex = (to.tex - from.tex) * scale;
+    if constexpr ((MASK & varying::Color) != 0) step.color = (to.color - from.color) * scale;
+    if constexpr ((MASK & varying::Diffuse) != 0) step.diffuse = (to.diffuse - from.diffuse) * scale;
+}
+
+// Number of pixels shaded together by a packet pixel shader.
+constexpr int PIXEL_PACKET = 8;
+
+/*
+Varyings of the pixels of a packet in structure of arrays layout, lane i of every array for pixel i, so a packet pixel
+shader loads each component straight into a vector register. Only the varyings of the effect's mask are filled.
+*/
+struct VaryingPacket
+{
+    alignas(32) float normal[3][PIXEL_PACKET];
+    alignas(32) float tex[3][PIXEL_PACKET]; // x, y, w
+    alignas(32) float color[3][PIXEL_PACKET];
+    alignas(32) float diffuse[PIXEL_PACKET];
+};
+
+// Lane of p = v, for the varyings in MASK only.
+template<unsigned MASK, class V>
+inline void storeVaryings(VaryingPacket& p, int lane, const V& v)
+{
+    if constexpr ((MASK & varying::Normal) != 0) {
+        p.normal[0][lane] = v.normal.x;
+        p.normal[1][lane] = v.normal.y;
+        p.normal[2][lane] = v.normal.z;
+    }
+    if constexpr ((MASK & varying::Tex) != 0) {
+        p.tex[0][lane] = v.tex.x;
+        p.tex[1][lane] = v.tex.y;
+        p.tex[2][lane] = v.tex.w;
+    }
+    if constexpr ((MASK & varying::Color) != 0) {
+        p.color[0][lane] = v.color.x;
+        p.color[1][lane] = v.color.y;
+        p.color[2][lane] = v.color.z;
+    }
+    if constexpr ((MASK & varying::Diffuse) != 0) p.diffuse[lane] = v.diffuse;
+}
+
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "slib.hpp"
+#include "alignedAllocator.hpp"
+
+// Number of vertices transformed per iteration of the batch vertex stage.
+constexpr int VERTEX_BATCH = 8;
+
+/*
+Structure of arrays copy of the vertex attributes of a solid, used by the batch vertex stage.
+The arrays are padded with zeros up to a multiple of VERTEX_BATCH so that full batches can always be loaded.
+*/
+struct VertexSoA
+{
+    typedef std::vector<float, AlignedAllocator<float>> Channel;
+    Channel x, y, z;    // Position
+    Channel nx, ny, nz; // Vertex normal
+    Channel u, v;       // Texture coordinates
+    int count = 0;      // Number of real vertices
+
+    int size() const { return count; }
+};
+
+// Result of the batch vertex stage for one vertex, handed to the VertexShader of the effect.
+struct TransformedVertex
+{
+    slib::vec3 world;
+    slib::vec4 ndc;
+    slib::vec3 normal;
+    slib::vec2 texCoord;
+};
+
+/*
+Matrices of the fused model -> world -> view -> clip pass, flattened row by row.
+- model: first three rows of the model matrix (its last row is 0 0 0 1), gives the world position.
+- clip: clip[k][j] multiplies coordinate k of the object space position to give clip coordinate j,
+  i.e. the model, view and projection matrices combined into one.
+- normal: upper 3x3 of the normal matrix.
+*/
+struct BatchMatrices
+{
+    float model[3][4];
+    float clip[4][4];
+    float normal[3][3];
+
+    BatchMatrices(const slib::mat4& modelMat, const slib::mat4& viewProjection, const slib::mat4& normalMat)
+    {
+        // world = model * v (column vector), ndc = world * viewProjection (row vector)
+        for (int i = 0; i < 3; ++i)
+            for (int k = 0; k < 4; ++k)
+                model[i][k] = modelMat.data[i][k];
+        for (int k = 0; k < 4; ++k) {
+            for (int j = 0; j < 4; ++j) {
+                float sum = 0;
+                for (int i = 0; i < 4; ++i) sum += modelMat.data[i][k] * viewProjection.data[i][j];
+                clip[k][j] = sum;
+            }
+        }
+        for (int i = 0; i < 3; ++i)
+            for (int k = 0; k < 3; ++k)
+                normal[i][k] = normalMat.data[i][k];
+    }
+};
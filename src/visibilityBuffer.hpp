@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "kernels/kernels.hpp"
+
+/*
+Screen space barycentric weights of the second and third vertex of a triangle as plane equations,
+w = a * (x - x0) + b * (y - y0), relative to the first vertex so that they keep their precision far from the origin.
+The weight of the first vertex is 1 - w1 - w2.
+*/
+struct BarycentricPlanes
+{
+	float x0, y0;
+	float a1, b1;
+	float a2, b2;
+
+	BarycentricPlanes( float x0, float y0, float x1, float y1, float x2, float y2 )
+		:
+		x0( x0 ),
+		y0( y0 )
+	{
+		double area = double( x1 - x0 ) * (y2 - y0) - double( x2 - x0 ) * (y1 - y0);
+		float invArea = area != 0.0 ? static_cast<float>(1.0 / area) : 0.0f; // Degenerate triangles collapse onto their first vertex
+		a1 = (y2 - y0) * invArea;
+		b1 = -(x2 - x0) * invArea;
+		a2 = -(y1 - y0) * invArea;
+		b2 = (x1 - x0) * invArea;
+	}
+	float W1( float x,float y ) const
+	{
+		return a1 * (x - x0) + b1 * (y - y0);
+	}
+	float W2( float x,float y ) const
+	{
+		return a2 * (x - x0) + b2 * (y - y0);
+	}
+};
+
+/*
+Per pixel record of the visibility buffer (deferred) mode: which triangle is nearest and where inside it.
+The depth itself stays in the ZBuffer. An id holds the slot of the rasterizer that owns the triangle in its top
+bits and the index of the triangle in that rasterizer's list for the frame in the rest; EMPTY marks uncovered pixels.
+*/
+class VisibilityBuffer
+{
+public:
+	static constexpr int SLOT_SHIFT = 28;
+	static constexpr uint32_t INDEX_MASK = (1u << SLOT_SHIFT) - 1;
+	static constexpr uint32_t EMPTY = 0xffffffff; // Its slot (15) is never given to a rasterizer
+
+	struct Weights
+	{
+		float w1, w2;
+	};
+
+	VisibilityBuffer( int width, int height )
+		:
+		width( width ),
+		height( height ),
+		ids( width*height, EMPTY ),
+		weights( width*height )
+	{}
+	VisibilityBuffer( const VisibilityBuffer& ) = delete;
+	void Clear()
+	{
+		kernels().fill( ids.data(),ids.size() * sizeof( uint32_t ),0xff ); // EMPTY in every byte
+	}
+	void Write( int pos,uint32_t id,float w1,float w2 )
+	{
+		ids[pos] = id;
+		weights[pos] = { w1, w2 };
+	}
+	uint32_t Id( int pos ) const
+	{
+		return ids[pos];
+	}
+	const Weights& At( int pos ) const
+	{
+		return weights[pos];
+	}
+	static uint32_t MakeId( int slot,uint32_t index )
+	{
+		return (static_cast<uint32_t>(slot) << SLOT_SHIFT) | index;
+	}
+	static int Slot( uint32_t id )
+	{
+		return static_cast<int>(id >> SLOT_SHIFT);
+	}
+private:
+	int width;
+	int height;
+	std::vector<uint32_t> ids;
+	std::vector<Weights> weights;
+};